@@ -55,6 +55,17 @@ namespace DeskGap {
         std::array<int, 2> GetSize();
         std::array<int, 2> GetPosition();
 
+    #ifdef __linux__
+        struct State {
+            int x, y;
+            int width, height;
+            bool focused;
+        };
+        // Unlike the other methods, this one can be called from any thread.
+        // It returns the state last reported by the window system without dispatching to the UI thread.
+        State GetState() const;
+    #endif
+
         void SetMaximumSize(int width, int height);
         void SetMinimumSize(int width, int height);
 
@@ -1,11 +1,25 @@
 #ifndef DESKGAP_DISPATCH_HPP
 #define DESKGAP_DISPATCH_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace DeskGap {
     void DispatchSync(std::function<void()>&& action);
     void DispatchAsync(std::function<void()>&& action);
+
+#ifdef __linux__
+    struct DispatchStats {
+        size_t queueDepth;
+        size_t maxQueueDepth;
+        uint64_t dispatchedActions;
+        uint64_t wakeups; // main loop iterations that drained the queue
+        uint64_t totalLatencyMicroseconds; // from being queued to being run
+        uint64_t maxLatencyMicroseconds;
+    };
+    DispatchStats GetDispatchStats();
+#endif
 }
 
 #endif /* ui_dispatch_h */
@@ -47,8 +47,18 @@ namespace DeskGap {
             MAIN = 0, CONTEXT = 1, SUBMENU = 2
         };
         Menu(const Menu&) = delete;
-        Menu(const Type&);
+
+        struct EventCallbacks {
+            // Called when the menu is about to be shown and after it is hidden, so that it can be filled on demand
+            std::function<void()> onShow;
+            std::function<void()> onHide;
+        };
+        Menu(const Type&, EventCallbacks&& = { });
         void AppendItem(const MenuItem& menuItem);
+        // Inserts the item before the one at index, or appends it if index is past the end
+        void InsertItem(const MenuItem& menuItem, size_t index);
+        // Takes the item out of the menu without destroying it
+        void RemoveItem(const MenuItem& menuItem);
 
         ~Menu();
     };
@@ -1,6 +1,7 @@
 #ifndef DESKGAP_WEBVIEW_HPP
 #define DESKGAP_WEBVIEW_HPP
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -32,16 +33,52 @@ namespace DeskGap {
         static bool IsWinRTWebViewAvailable();
         static std::string GetWebview2Version();
         #endif
+        #ifdef __linux__
+        // Characters owned by the JS engine of the page. They stay valid until the last copy of `owner` is released,
+        // which can happen on any thread.
+        struct UTF16String {
+            std::shared_ptr<const void> owner;
+            size_t length;
+            // The JS engine keeps the strings that only have Latin-1 characters in 8 bits, and widens them here.
+            // Called by the receiver, so the UI thread does not convert them. Thread-safe.
+            const char16_t* Characters() const;
+        };
+        #endif
         struct EventCallbacks {
             std::function<void()> didFinishLoad;
+            #ifndef __linux__
             std::function<void(std::string&&)> onStringMessage;
+            #endif
             std::function<void(const std::string&)> onPageTitleUpdated;
+            // Only called by the GTK implementation, other platforms fall back to string messages in JS.
+            std::function<void(std::vector<uint8_t>&&)> onBinaryMessage;
+            #ifdef __linux__
+            // The string messages of the GTK implementation, whose characters are converted once, by the receiver.
+            std::function<void(UTF16String&&)> onUTF16StringMessage;
+            #endif
         };
 
         #ifndef WIN32
         WebView(EventCallbacks&&, const std::string& preloadScriptString);
         #endif
 
+        #ifdef __linux__
+        // Web views created with the same non-empty partition share one WebKitWebContext,
+        // and so its network process, caches and web processes. An empty partition gets a context of its own.
+        WebView(EventCallbacks&&, const std::string& preloadScriptString, const std::string& partition);
+
+        struct ContextOptions {
+            enum class CacheModel: uint32_t {
+                DOCUMENT_VIEWER = 0, DOCUMENT_BROWSER = 1, WEB_BROWSER = 2
+            };
+            CacheModel cacheModel = CacheModel::WEB_BROWSER;
+            // Ignored by WebKitGTK 2.26 and later. 0 means no limit.
+            uint32_t webProcessCountLimit = 0;
+        };
+        // Applies to the contexts created afterwards.
+        static void SetContextOptions(const ContextOptions& options);
+        #endif
+
         struct HTTPHeader {
             std::string field;
             std::string value;
@@ -60,6 +97,16 @@ namespace DeskGap {
 
         PURE_VIRTUAL_IF_WIN32(void SetDevToolsEnabled(bool enabled));
 
+        #ifdef __linux__
+        // Queues the bytes for the page, which pulls them through the deskgap-ipc scheme as an ArrayBuffer.
+        void PostBinaryMessage(std::vector<uint8_t>&& data);
+
+        // Makes local files served with COOP/COEP headers, so SharedArrayBuffer is available to the page.
+        // Takes effect from the next request. Requires WebKitGTK 2.36, which can set response headers.
+        // Isolating also registers the local scheme as secure in the web context of the view, for good.
+        void SetCrossOriginIsolated(bool isolated);
+        #endif
+
         #ifdef WIN32
         inline virtual ~WebView() = default;
         #else
@@ -7,17 +7,60 @@
 namespace DeskGap {
     int i = 0;
 
+    void BrowserWindow::Impl::StateCache::Store(const BrowserWindow::State& state) {
+        uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        x_.store(state.x, std::memory_order_relaxed);
+        y_.store(state.y, std::memory_order_relaxed);
+        width_.store(state.width, std::memory_order_relaxed);
+        height_.store(state.height, std::memory_order_relaxed);
+        focused_.store(state.focused, std::memory_order_relaxed);
+
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    BrowserWindow::State BrowserWindow::Impl::StateCache::Load() const {
+        BrowserWindow::State state;
+        uint32_t before, after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            state.x = x_.load(std::memory_order_relaxed);
+            state.y = y_.load(std::memory_order_relaxed);
+            state.width = width_.load(std::memory_order_relaxed);
+            state.height = height_.load(std::memory_order_relaxed);
+            state.focused = focused_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        return state;
+    }
+
+    void BrowserWindow::Impl::UpdateGeometry() {
+        gtk_window_get_position(gtkWindow, &state.x, &state.y);
+        gtk_window_get_size(gtkWindow, &state.width, &state.height);
+        stateCache.Store(state);
+    }
+
+    void BrowserWindow::Impl::UpdateFocus(bool focused) {
+        state.focused = focused;
+        stateCache.Store(state);
+    }
+
     bool BrowserWindow::Impl::HandleDeleteEvent(GtkWidget*, GdkEvent*, BrowserWindow* window) {
         window->impl_->callbacks.onClose();
         return true;
     }
 
     bool BrowserWindow::Impl::HandleFocusInEvent(GtkWidget*, GdkEvent*, BrowserWindow* window) {
+        window->impl_->UpdateFocus(true);
         window->impl_->callbacks.onFocus();
         return FALSE;
     }
 
     bool BrowserWindow::Impl::HandleFocusOutEvent(GtkWidget*, GdkEvent*, BrowserWindow* window) {
+        window->impl_->UpdateFocus(false);
         window->impl_->callbacks.onBlur();
         return FALSE;
     }
@@ -25,6 +68,8 @@ namespace DeskGap {
     bool BrowserWindow::Impl::HandleConfigureEvent(GtkWidget*, GdkEventConfigure* eventConfigure, BrowserWindow* window) {
         std::optional<Rect>& lastRect = window->impl_->lastRect;
         const BrowserWindow::EventCallbacks& callbacks = window->impl_->callbacks;
+        // Updated before the callbacks, so getters called from onResize/onMove see the new geometry.
+        window->impl_->UpdateGeometry();
         if (!lastRect.has_value()) {
             callbacks.onResize();
             callbacks.onMove();
@@ -69,6 +114,7 @@ namespace DeskGap {
 
         impl_->gtkWindow = gtkWindow;
         impl_->gtkBox = gtkBox;
+        impl_->UpdateGeometry();
     }
 
     BrowserWindow::~BrowserWindow() {
@@ -78,6 +124,7 @@ namespace DeskGap {
 
     void BrowserWindow::Show() {
         gtk_widget_show(GTK_WIDGET(impl_->gtkWindow));
+        impl_->UpdateGeometry();
     }
 
     void BrowserWindow::SetMaximizable(bool maximizable) {
@@ -103,6 +150,7 @@ namespace DeskGap {
 
     void BrowserWindow::SetSize(int width, int height, bool animate) {
         gtk_window_resize(impl_->gtkWindow, width, height);
+        impl_->UpdateGeometry();
     }
 
     void BrowserWindow::SetMaximumSize(int width, int height) {
@@ -120,6 +168,7 @@ namespace DeskGap {
 
     void BrowserWindow::SetPosition(int x, int y, bool animate) {
         gtk_window_move(impl_->gtkWindow, x, y);
+        impl_->UpdateGeometry();
     }
 
     std::array<int, 2> BrowserWindow::GetSize() {
@@ -134,6 +183,10 @@ namespace DeskGap {
         return { x, y };
     }
 
+    BrowserWindow::State BrowserWindow::GetState() const {
+        return impl_->stateCache.Load();
+    }
+
     void BrowserWindow::Minimize() {
         gtk_window_iconify(impl_->gtkWindow);
     }
@@ -149,6 +202,7 @@ namespace DeskGap {
         gtk_window_get_size(impl_->gtkWindow, &windowWidth, &windowHeight);
 
         gtk_window_move(impl_->gtkWindow, (screenWidth - windowWidth) / 2, (screenHeight - windowHeight) / 2);
+        impl_->UpdateGeometry();
     }
 
     void BrowserWindow::SetMenu(const Menu* menu) {
@@ -169,7 +223,7 @@ namespace DeskGap {
 
     void BrowserWindow::SetIcon(const std::optional<std::string>& iconPath) {
         if (iconPath.has_value()) {
-            GError* error;
+            GError* error = nullptr;
             gtk_window_set_icon_from_file(impl_->gtkWindow, iconPath->c_str(), &error);
             GlibException::ThrowAndFree(error);
         }
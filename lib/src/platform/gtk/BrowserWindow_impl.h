@@ -3,6 +3,7 @@
 
 #include <gtk/gtk.h>
 #include <memory>
+#include <atomic>
 
 #include "browser_window.hpp"
 
@@ -38,6 +39,21 @@ namespace DeskGap {
             gint x, y, width, height;
         };
         std::optional<Rect> lastRect;
+
+        // A seqlock: written only on the UI thread, read from any thread without blocking the writer.
+        class StateCache {
+        private:
+            std::atomic<uint32_t> sequence_ { 0 };
+            std::atomic<int> x_ { 0 }, y_ { 0 }, width_ { 0 }, height_ { 0 };
+            std::atomic<bool> focused_ { false };
+        public:
+            void Store(const BrowserWindow::State&);
+            BrowserWindow::State Load() const;
+        };
+        StateCache stateCache;
+        BrowserWindow::State state { };
+        void UpdateGeometry();
+        void UpdateFocus(bool focused);
     };
 }
 
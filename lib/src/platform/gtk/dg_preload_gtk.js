@@ -1,7 +1,52 @@
+var isReceivingBinaryMessages = false;
+var hasPendingBinaryMessages = false;
+
 window.deskgap = {
     platform: 'linux',
     postStringMessage: function (string) {
         window.webkit.messageHandlers.stringMessage.postMessage(string);
+    },
+    postBinaryMessage: function (arrayBuffer) {
+        window.webkit.messageHandlers.binaryMessage.postMessage(arrayBuffer);
+    },
+    // Set by preload.ts
+    binaryMessageReceived: null,
+    // Drains the messages queued by WebView::PostBinaryMessage, see HandleIpcUriSchemeRequest for the framing.
+    receiveBinaryMessages: function () {
+        if (isReceivingBinaryMessages) {
+            hasPendingBinaryMessages = true;
+            return;
+        }
+        isReceivingBinaryMessages = true;
+        hasPendingBinaryMessages = false;
+
+        var internalDeskGap = this;
+        var finish = function () {
+            isReceivingBinaryMessages = false;
+            if (hasPendingBinaryMessages) {
+                internalDeskGap.receiveBinaryMessages();
+            }
+        };
+        fetch('deskgap-ipc://host/receive').then(function (response) {
+            return response.arrayBuffer();
+        }).then(function (buffer) {
+            var view = new DataView(buffer);
+            var offset = 0;
+            while (offset + 4 <= buffer.byteLength) {
+                var length = view.getUint32(offset, true);
+                offset += 4;
+                var message = buffer.slice(offset, offset + length);
+                offset += length;
+                if (internalDeskGap.binaryMessageReceived != null) {
+                    try {
+                        internalDeskGap.binaryMessageReceived(message);
+                    }
+                    catch (e) {
+                        setTimeout(function () { throw e; });
+                    }
+                }
+            }
+        }).then(finish, finish);
     }
 }
 
@@ -1,6 +1,7 @@
 #include "menu.hpp"
 #include "menu_impl.h"
 
+#include <algorithm>
 #include <unordered_map>
 
 namespace DeskGap {
@@ -34,6 +35,11 @@ namespace DeskGap {
         menuItem->impl_->callbacks.onClick();
     }
     MenuItem::~MenuItem() {
+        // Not SetAccelGroup(nullptr), which would reach the submenu that may have been destroyed
+        if (impl_->accelGroup != nullptr) {
+            impl_->RemoveAccelerator();
+            g_object_unref(impl_->accelGroup);
+        }
         if (impl_->activateConnection > 0) {
             g_signal_handler_disconnect(impl_->gtkMenuItem, impl_->activateConnection);
         }
@@ -92,6 +98,7 @@ namespace DeskGap {
             { "printscreen", GDK_KEY_Print }
         };
 
+        impl_->RemoveAccelerator();
         if (tokens.empty()) {
             impl_->accelInfo.reset();
             return;
@@ -114,9 +121,41 @@ namespace DeskGap {
         impl_->accelInfo.emplace(Impl::AccelInfo {
             key, mods
         });
+        impl_->AddAccelerator();
+    }
+
+    void MenuItem::Impl::AddAccelerator() {
+        if (accelGroup != nullptr && accelInfo.has_value()) {
+            gtk_widget_add_accelerator(
+                GTK_WIDGET(gtkMenuItem),
+                "activate",
+                accelGroup,
+                accelInfo->key, accelInfo->mods,
+                GTK_ACCEL_VISIBLE
+            );
+        }
     }
 
-    Menu::Menu(const Type& type): impl_(std::make_unique<Impl>()) {
+    void MenuItem::Impl::RemoveAccelerator() {
+        if (accelGroup != nullptr && accelInfo.has_value()) {
+            gtk_widget_remove_accelerator(GTK_WIDGET(gtkMenuItem), accelGroup, accelInfo->key, accelInfo->mods);
+        }
+    }
+
+    void MenuItem::Impl::SetAccelGroup(GtkAccelGroup* newAccelGroup) {
+        if (newAccelGroup == accelGroup) return;
+        if (accelGroup != nullptr) {
+            RemoveAccelerator();
+            g_object_unref(accelGroup);
+        }
+        accelGroup = newAccelGroup == nullptr ? nullptr : GTK_ACCEL_GROUP(g_object_ref(newAccelGroup));
+        AddAccelerator();
+        if (submenu.has_value()) {
+            submenu->get().impl_->SetAccelGroup(newAccelGroup);
+        }
+    }
+
+    Menu::Menu(const Type& type, EventCallbacks&& callbacks): impl_(std::make_unique<Impl>()) {
         if (type == Type::MAIN) {
             impl_->gtkMenuShell = GTK_MENU_SHELL(g_object_ref_sink(gtk_menu_bar_new()));
         }
@@ -124,32 +163,71 @@ namespace DeskGap {
             impl_->gtkMenuShell = GTK_MENU_SHELL(g_object_ref_sink(gtk_menu_new()));
         }
         gtk_widget_show(GTK_WIDGET(impl_->gtkMenuShell));
+
+        // A GtkMenu is shown once, and mapped each time its popup window is
+        if (callbacks.onShow || callbacks.onHide) {
+            impl_->callbacks = std::move(callbacks);
+            impl_->mapConnection = g_signal_connect(impl_->gtkMenuShell, "map", G_CALLBACK(Impl::HandleMap), this);
+            impl_->unmapConnection = g_signal_connect(impl_->gtkMenuShell, "unmap", G_CALLBACK(Impl::HandleUnmap), this);
+        }
+    }
+
+    void Menu::Impl::HandleMap(GtkWidget*, Menu* menu) {
+        if (menu->impl_->callbacks.onShow) {
+            menu->impl_->callbacks.onShow();
+        }
+    }
+    void Menu::Impl::HandleUnmap(GtkWidget*, Menu* menu) {
+        if (menu->impl_->callbacks.onHide) {
+            menu->impl_->callbacks.onHide();
+        }
     }
 
     void Menu::AppendItem(const MenuItem& menuItem) {
-        impl_->items.emplace_back(menuItem);
-        gtk_menu_shell_append(impl_->gtkMenuShell, GTK_WIDGET(menuItem.impl_->gtkMenuItem));
+        InsertItem(menuItem, impl_->items.size());
     }
 
-    void Menu::Impl::SetAccelGroup(GtkAccelGroup* accelGroup) const {
-        for (const MenuItem& menuItem: items) {
-            if (const auto& accelInfo = menuItem.impl_->accelInfo; accelInfo.has_value()) {
-                gtk_widget_add_accelerator(
-                    GTK_WIDGET(menuItem.impl_->gtkMenuItem),
-                    "activate",
-                    accelGroup,
-                    accelInfo->key, accelInfo->mods,
-                    GTK_ACCEL_VISIBLE
-                );
-            }
-            if (menuItem.impl_->submenu.has_value()) {
-                menuItem.impl_->submenu->get().impl_->SetAccelGroup(accelGroup);
+    void Menu::InsertItem(const MenuItem& menuItem, size_t index) {
+        index = std::min(index, impl_->items.size());
+        impl_->items.emplace(impl_->items.begin() + index, menuItem);
+        gtk_menu_shell_insert(impl_->gtkMenuShell, GTK_WIDGET(menuItem.impl_->gtkMenuItem), static_cast<gint>(index));
+        menuItem.impl_->SetAccelGroup(impl_->accelGroup);
+    }
+
+    void Menu::RemoveItem(const MenuItem& menuItem) {
+        auto& items = impl_->items;
+        auto it = std::find_if(items.begin(), items.end(), [&](const MenuItem& item) {
+            return &item == &menuItem;
+        });
+        if (it == items.end()) return;
+        items.erase(it);
+        menuItem.impl_->SetAccelGroup(nullptr);
+        // The item keeps its own reference, so the widget survives being removed
+        gtk_container_remove(GTK_CONTAINER(impl_->gtkMenuShell), GTK_WIDGET(menuItem.impl_->gtkMenuItem));
+    }
+
+    void Menu::Impl::SetAccelGroup(GtkAccelGroup* newAccelGroup) const {
+        if (newAccelGroup != accelGroup) {
+            if (accelGroup != nullptr) {
+                g_object_unref(accelGroup);
             }
+            accelGroup = newAccelGroup == nullptr ? nullptr : GTK_ACCEL_GROUP(g_object_ref(newAccelGroup));
+        }
+        for (const MenuItem& menuItem: items) {
+            menuItem.impl_->SetAccelGroup(newAccelGroup);
         }
     }
 
 
     Menu::~Menu() {
+        // The shell can outlive the menu as the submenu of an item
+        if (impl_->mapConnection > 0) {
+            g_signal_handler_disconnect(impl_->gtkMenuShell, impl_->mapConnection);
+            g_signal_handler_disconnect(impl_->gtkMenuShell, impl_->unmapConnection);
+        }
+        if (impl_->accelGroup != nullptr) {
+            g_object_unref(impl_->accelGroup);
+        }
         g_object_unref(impl_->gtkMenuShell);
     };
 }
@@ -22,12 +22,27 @@ namespace DeskGap {
         };
         std::optional<AccelInfo> accelInfo;
         std::optional<std::reference_wrapper<const Menu>> submenu;
+
+        // The accel group of the window the item is shown in, referenced by the item so that
+        // its accelerator can be changed or removed after the menu is attached
+        GtkAccelGroup* accelGroup = nullptr;
+        void SetAccelGroup(GtkAccelGroup* accelGroup);
+        void AddAccelerator();
+        void RemoveAccelerator();
     };
     
     struct Menu::Impl {
         GtkMenuShell* gtkMenuShell;
         std::vector<std::reference_wrapper<const MenuItem>> items;
 
+        Menu::EventCallbacks callbacks;
+        gulong mapConnection = 0;
+        gulong unmapConnection = 0;
+        static void HandleMap(GtkWidget*, Menu*);
+        static void HandleUnmap(GtkWidget*, Menu*);
+
+        // Given to the items inserted later
+        mutable GtkAccelGroup* accelGroup = nullptr;
         void SetAccelGroup(GtkAccelGroup* accelGroup) const;
     };
 }
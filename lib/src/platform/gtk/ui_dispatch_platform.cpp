@@ -1,9 +1,12 @@
 #include <utility>
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <cerrno>
 #include <functional>
 
 #include <gtk/gtk.h>
+#include <glib-unix.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 #include "dispatch.hpp"
 #include "./glib_exception.h"
@@ -13,20 +16,152 @@
 namespace {
     using Action = std::function<void()>;
 
-    void GIdleAdd(Action&& action) {
-        g_idle_add([](void* data) -> gboolean {
-            auto action = static_cast<Action*>(data);
-            (*action)();
-            delete action;
-            return FALSE;
-        }, new Action(std::move(action)));
-    }
+    // Actions from any thread are pushed into an intrusive multi-producer single-consumer queue
+    // (Vyukov's algorithm, so pushing is one atomic exchange). Only the push that makes the queue non-empty
+    // writes to the eventfd, and the main loop drains everything queued so far in one wakeup,
+    // instead of one idle source and one main loop iteration per action.
+    class DispatchQueue {
+    private:
+        struct Node {
+            std::atomic<Node*> next { nullptr };
+            Action action;
+            gint64 enqueueTime;
+        };
+
+        std::atomic<Node*> head_;
+        Node* tail_;
+        Node stub_;
+
+        std::atomic<size_t> depth_ { 0 };
+        int eventFd_;
+
+        std::atomic<uint64_t> dispatchedActions_ { 0 };
+        std::atomic<uint64_t> wakeups_ { 0 };
+        std::atomic<size_t> maxDepth_ { 0 };
+        std::atomic<uint64_t> totalLatency_ { 0 };
+        std::atomic<uint64_t> maxLatency_ { 0 };
+
+        template<class T>
+        static void StoreMax(std::atomic<T>& maximum, T value) {
+            T current = maximum.load(std::memory_order_relaxed);
+            while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed));
+        }
+
+        void Link(Node* node) {
+            node->next.store(nullptr, std::memory_order_relaxed);
+            Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        // Returns nullptr if the queue is empty or a producer is in the middle of linking its node.
+        Node* Pop() {
+            Node* tail = tail_;
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (tail == &stub_) {
+                if (next == nullptr) return nullptr;
+                tail_ = next;
+                tail = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+            if (next != nullptr) {
+                tail_ = next;
+                return tail;
+            }
+            if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+
+            Link(&stub_);
+            next = tail->next.load(std::memory_order_acquire);
+            if (next != nullptr) {
+                tail_ = next;
+                return tail;
+            }
+            return nullptr;
+        }
+
+        void Wake() {
+            uint64_t one = 1;
+            while (write(eventFd_, &one, sizeof(one)) < 0 && errno == EINTR);
+        }
+
+        static gboolean HandleWakeup(gint fd, GIOCondition, gpointer data) {
+            auto queue = static_cast<DispatchQueue*>(data);
+            uint64_t count;
+            while (read(fd, &count, sizeof(count)) < 0 && errno == EINTR);
+            queue->Drain();
+            return G_SOURCE_CONTINUE;
+        }
+
+        void Drain() {
+            wakeups_.fetch_add(1, std::memory_order_relaxed);
+            while (Node* node = Pop()) {
+                // The depth is decreased before running the action, so an action that spins a nested
+                // main loop (like gtk_dialog_run) does not keep later pushes from waking that loop up.
+                depth_.fetch_sub(1, std::memory_order_acq_rel);
+
+                uint64_t latency = g_get_monotonic_time() - node->enqueueTime;
+                totalLatency_.fetch_add(latency, std::memory_order_relaxed);
+                StoreMax(maxLatency_, latency);
+                dispatchedActions_.fetch_add(1, std::memory_order_relaxed);
+
+                Action action = std::move(node->action);
+                delete node;
+                action();
+            }
+            // A producer has counted its action but not finished linking it.
+            // Come back on the next iteration instead of spinning here.
+            if (depth_.load(std::memory_order_acquire) > 0) {
+                Wake();
+            }
+        }
+    public:
+        DispatchQueue(): head_(&stub_), tail_(&stub_) {
+            eventFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            GSource* source = g_unix_fd_source_new(eventFd_, G_IO_IN);
+            // Keep the priority of g_idle_add so actions are still run after pending redraws.
+            g_source_set_priority(source, G_PRIORITY_DEFAULT_IDLE);
+            g_source_set_can_recurse(source, TRUE);
+            g_source_set_callback(source, reinterpret_cast<GSourceFunc>(HandleWakeup), this, nullptr);
+            g_source_attach(source, nullptr);
+            g_source_unref(source);
+        }
+
+        void Push(Action&& action) {
+            auto node = new Node();
+            node->action = std::move(action);
+            node->enqueueTime = g_get_monotonic_time();
+
+            // Counted before being linked, so the consumer never sees an action it cannot account for.
+            size_t previousDepth = depth_.fetch_add(1, std::memory_order_acq_rel);
+            StoreMax(maxDepth_, previousDepth + 1);
+            Link(node);
+
+            if (previousDepth == 0) {
+                Wake();
+            }
+        }
+
+        DeskGap::DispatchStats Stats() const {
+            return DeskGap::DispatchStats {
+                depth_.load(std::memory_order_relaxed),
+                maxDepth_.load(std::memory_order_relaxed),
+                dispatchedActions_.load(std::memory_order_relaxed),
+                wakeups_.load(std::memory_order_relaxed),
+                totalLatency_.load(std::memory_order_relaxed),
+                maxLatency_.load(std::memory_order_relaxed),
+            };
+        }
+
+        static DispatchQueue& Shared() {
+            static DispatchQueue queue;
+            return queue;
+        }
+    };
 }
 
 
 void DeskGap::DispatchSync(std::function<void()>&& action) {
     Semaphore semaphore;
-    GIdleAdd([&]() {
+    DispatchQueue::Shared().Push([&]() {
         action();
         semaphore.signal();
     });
@@ -34,9 +169,9 @@ void DeskGap::DispatchSync(std::function<void()>&& action) {
 }
 
 void DeskGap::DispatchAsync(std::function<void()>&& action) {
-    GIdleAdd([
-        action { std::move(action) }
-    ]() {
-        action();
-    });
+    DispatchQueue::Shared().Push(std::move(action));
+}
+
+DeskGap::DispatchStats DeskGap::GetDispatchStats() {
+    return DispatchQueue::Shared().Stats();
 }
@@ -1,32 +1,49 @@
 #ifndef gtk_util_convert_js_result_h
 #define gtk_util_convert_js_result_h
 
-#include <string>
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <vector>
 #include <webkit2/webkit2.h>
 #include <JavaScriptCore/JSValueRef.h>
 #include <JavaScriptCore/JSStringRef.h>
+#include <JavaScriptCore/JSTypedArray.h>
+
+#include "webview.hpp"
 
 namespace {
-	std::optional<std::string> jsResultToString(WebKitJavascriptResult* jsResult) {
+	// Refers to the characters of the string instead of converting them to UTF-8 in a buffer of the worst-case size.
+	// JSValueToStringCopy makes a thread-safe string, so it can be read and released on the Node thread.
+	std::optional<DeskGap::WebView::UTF16String> jsResultToUTF16String(WebKitJavascriptResult* jsResult) {
 		JSGlobalContextRef context = webkit_javascript_result_get_global_context (jsResult);
-    	JSValueRef value = webkit_javascript_result_get_value (jsResult);
+		JSValueRef value = webkit_javascript_result_get_value (jsResult);
 
-    	if (!JSValueIsString(context, value)) {
-    		return std::nullopt;
-    	}
+		if (!JSValueIsString(context, value)) {
+			return std::nullopt;
+		}
 
-        JSStringRef jsString = JSValueToStringCopy(context, value, NULL);
-        gsize maxStringSize = JSStringGetMaximumUTF8CStringSize(jsString);
+		JSStringRef jsString = JSValueToStringCopy(context, value, NULL);
+		return DeskGap::WebView::UTF16String {
+			std::shared_ptr<const void>(jsString, JSStringRelease),
+			JSStringGetLength(jsString)
+		};
+	}
 
-        std::string result(maxStringSize - 1, '\0');
-        size_t exactStringSize = JSStringGetUTF8CString(jsString, result.data(), maxStringSize) - 1;
+	// The preload script only posts whole ArrayBuffers, so typed array views are not handled here.
+	std::optional<std::vector<uint8_t>> jsResultToBytes(WebKitJavascriptResult* jsResult) {
+		JSGlobalContextRef context = webkit_javascript_result_get_global_context (jsResult);
+		JSValueRef value = webkit_javascript_result_get_value (jsResult);
 
-        JSStringRelease(jsString);
+		if (JSValueGetTypedArrayType(context, value, NULL) != kJSTypedArrayTypeArrayBuffer) {
+			return std::nullopt;
+		}
 
-        result.resize(exactStringSize);
+		JSObjectRef arrayBuffer = JSValueToObject(context, value, NULL);
+		auto bytes = static_cast<const uint8_t*>(JSObjectGetArrayBufferBytesPtr(context, arrayBuffer, NULL));
+		size_t byteLength = JSObjectGetArrayBufferByteLength(context, arrayBuffer, NULL);
 
-        return std::make_optional<std::string>(std::move(result));
+		return std::make_optional<std::vector<uint8_t>>(bytes, bytes + byteLength);
 	}
 }
 
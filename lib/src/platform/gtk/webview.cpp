@@ -1,11 +1,16 @@
+#include <algorithm>
 #include <filesystem>
+#include <memory>
 #include <unordered_set>
+#include <unordered_map>
 #include <cstring>
 #include <gtk/gtk.h>
+#include <glib/gstdio.h>
 
 #include "webview.hpp"
 #include "webview_impl.h"
 #include "../../utils/mime.hpp"
+#include "../../utils/asset_archive.hpp"
 #include "./glib_exception.h"
 #include "./util/convert_js_result.h"
 
@@ -17,6 +22,20 @@ namespace fs = std::filesystem;
 
 namespace {
     const gchar* localURLScheme = "deskgap-local";
+    const gchar* ipcURLScheme = "deskgap-ipc";
+    const gchar* assetArchiveExtension = ".dgpack";
+    const gchar* binaryMessagesAvailableScript = "window.deskgap.__binaryMessagesAvailable()";
+    // The WebView that owns a WebKitWebView, looked up by the scheme handlers, which are shared by every view of a context
+    const gchar* webViewDataKey = "deskgap-webview";
+
+    DeskGap::WebView::ContextOptions contextOptions;
+
+    DeskGap::WebView* WebViewOfRequest(WebKitURISchemeRequest* request) {
+        WebKitWebView* gtkWebView = webkit_uri_scheme_request_get_web_view(request);
+        if (gtkWebView == nullptr) return nullptr;
+        return static_cast<DeskGap::WebView*>(g_object_get_data(G_OBJECT(gtkWebView), webViewDataKey));
+    }
+
     gboolean HandleContextMenu(WebKitWebView*, WebKitContextMenu *menu, GdkEvent*, WebKitHitTestResult*, gpointer) {
         static const std::unordered_set<WebKitContextMenuAction> kActionsToBeDeleted {
             WEBKIT_CONTEXT_MENU_ACTION_OPEN_LINK,
@@ -53,13 +72,418 @@ namespace {
         }
         return FALSE;
     }
+
+    struct LocalResponseOptions {
+        std::string_view mimeType;
+        // Adds the headers that make the page cross-origin isolated, which enables SharedArrayBuffer (and threaded wasm).
+        bool isCrossOriginIsolated;
+    };
+
+    enum class LocalRangeResult { IGNORED, SATISFIABLE, UNSATISFIABLE };
+
+    // Only the first range is served. Media elements never ask for more than one.
+    // A header that cannot be parsed is ignored and the whole body is served (RFC 9110, section 14.2),
+    // and only a valid range that starts past the end of the body is unsatisfiable.
+    // soup_message_headers_get_ranges fails in both cases, so the header is first parsed against the largest body.
+    LocalRangeResult ParseLocalRange(const std::string& rangeHeader, goffset totalSize, goffset* start, goffset* end) {
+        if (rangeHeader.empty()) {
+            return LocalRangeResult::IGNORED;
+        }
+        SoupMessageHeaders* headers = soup_message_headers_new(SOUP_MESSAGE_HEADERS_REQUEST);
+        soup_message_headers_append(headers, "Range", rangeHeader.c_str());
+
+        LocalRangeResult result = LocalRangeResult::IGNORED;
+        SoupRange* ranges;
+        int rangeCount;
+        if (soup_message_headers_get_ranges(headers, G_MAXINT64, &ranges, &rangeCount)) {
+            soup_message_headers_free_ranges(headers, ranges);
+            result = LocalRangeResult::UNSATISFIABLE;
+            if (soup_message_headers_get_ranges(headers, totalSize, &ranges, &rangeCount)) {
+                *start = ranges[0].start;
+                *end = ranges[0].end;
+                soup_message_headers_free_ranges(headers, ranges);
+                result = LocalRangeResult::SATISFIABLE;
+            }
+        }
+        soup_message_headers_free(headers);
+        return result;
+    }
+
+    // A larger range of a file is cut to this length, which a 206 response may do. The media element asks for the rest.
+    constexpr goffset kMaxLocalRangeLength = 8 * 1024 * 1024;
+
+    struct LocalFileRequest {
+        WebKitURISchemeRequest* request;
+        std::string path;
+        LocalResponseOptions responseOptions;
+        // Empty if the request has no Range header. Copied so the worker thread does not read the request.
+        std::string rangeHeader;
+
+        // Set by the worker thread.
+        // Whether a precompressed sibling is served. Range requests always get the original file.
+        bool isGzipped = false;
+        // -1 if the size is unknown, as for a precompressed sibling
+        goffset totalSize = -1;
+        LocalRangeResult rangeResult = LocalRangeResult::IGNORED;
+        goffset rangeStart = 0;
+        goffset rangeEnd = 0;
+
+        ~LocalFileRequest() {
+            g_object_unref(request);
+        }
+    };
+
+    // The sibling is stale if the original file has been modified after it, which happens when only the original is rebuilt
+    bool IsGzippedSiblingUsable(const std::string& path, const std::string& gzippedPath) {
+        GStatBuf gzippedStat, originalStat;
+        if (g_stat(gzippedPath.c_str(), &gzippedStat) != 0) {
+            return false;
+        }
+        if (g_stat(path.c_str(), &originalStat) != 0) {
+            return true;
+        }
+        return gzippedStat.st_mtime >= originalStat.st_mtime;
+    }
+
+    GFileInputStream* OpenLocalFile(const std::string& path, GError** error) {
+        GFile* file = g_file_new_for_path(path.c_str());
+        GFileInputStream* stream = g_file_read(file, nullptr, error);
+        g_object_unref(file);
+        return stream;
+    }
+
+    // Returns the body of the response as a GInputStream.
+    // The file is read, not mapped: a file truncated while it is served ends the body early instead of raising SIGBUS,
+    // and a GFileInputStream cannot be polled, so WebKit reads it on a thread of the GIO pool instead of the UI thread.
+    // A range is read here, into memory, as WebKit reads a stream to its end whatever the length of the response is.
+    void OpenLocalFileInThread(GTask* task, gpointer, gpointer taskData, GCancellable*) {
+        auto localFileRequest = static_cast<LocalFileRequest*>(taskData);
+        if (localFileRequest->rangeHeader.empty()) {
+            std::string gzippedPath = localFileRequest->path + ".gz";
+            if (IsGzippedSiblingUsable(localFileRequest->path, gzippedPath)) {
+                if (GFileInputStream* stream = OpenLocalFile(gzippedPath, nullptr); stream != nullptr) {
+                    localFileRequest->isGzipped = true;
+                    g_task_return_pointer(task, stream, g_object_unref);
+                    return;
+                }
+            }
+        }
+
+        GError* error = nullptr;
+        GFileInputStream* stream = OpenLocalFile(localFileRequest->path, &error);
+        if (stream == nullptr) {
+            g_task_return_error(task, error);
+            return;
+        }
+        if (GFileInfo* info = g_file_input_stream_query_info(stream, G_FILE_ATTRIBUTE_STANDARD_SIZE, nullptr, nullptr); info != nullptr) {
+            localFileRequest->totalSize = g_file_info_get_size(info);
+            g_object_unref(info);
+        }
+        if (localFileRequest->totalSize < 0) {
+            localFileRequest->rangeHeader.clear();
+        }
+
+        localFileRequest->rangeResult = ParseLocalRange(
+            localFileRequest->rangeHeader, localFileRequest->totalSize,
+            &localFileRequest->rangeStart, &localFileRequest->rangeEnd
+        );
+        if (localFileRequest->rangeResult == LocalRangeResult::IGNORED) {
+            g_task_return_pointer(task, stream, g_object_unref);
+            return;
+        }
+
+        GBytes* rangeBytes = nullptr;
+        if (localFileRequest->rangeResult == LocalRangeResult::SATISFIABLE) {
+            goffset length = std::min(localFileRequest->rangeEnd - localFileRequest->rangeStart + 1, kMaxLocalRangeLength);
+            auto buffer = static_cast<gchar*>(g_malloc(length));
+            gsize bytesRead = 0;
+            if (!g_seekable_seek(G_SEEKABLE(stream), localFileRequest->rangeStart, G_SEEK_SET, nullptr, &error) ||
+                !g_input_stream_read_all(G_INPUT_STREAM(stream), buffer, length, &bytesRead, nullptr, &error)) {
+                g_free(buffer);
+                g_object_unref(stream);
+                g_task_return_error(task, error);
+                return;
+            }
+            if (bytesRead == 0) {
+                // The file has been truncated since its size was queried
+                g_free(buffer);
+                localFileRequest->rangeResult = LocalRangeResult::UNSATISFIABLE;
+            }
+            else {
+                localFileRequest->rangeEnd = localFileRequest->rangeStart + bytesRead - 1;
+                rangeBytes = g_bytes_new_take(buffer, bytesRead);
+            }
+        }
+        g_object_unref(stream);
+        if (rangeBytes == nullptr) {
+            rangeBytes = g_bytes_new(nullptr, 0);
+        }
+        g_task_return_pointer(task, g_memory_input_stream_new_from_bytes(rangeBytes), g_object_unref);
+        g_bytes_unref(rangeBytes);
+    }
+
+    bool HasLocalScheme(const gchar* uri) {
+        gchar* scheme = g_uri_parse_scheme(uri);
+        bool isLocal = scheme != nullptr && g_ascii_strcasecmp(scheme, localURLScheme) == 0;
+        g_free(scheme);
+        return isLocal;
+    }
+
+    // Whether the page of the web view is a local one, and the request is not made by a frame of another origin.
+    // The frame is told by the Origin header, which WebKitGTK only exposes since 2.36.
+    bool IsRequestFromLocalPage(WebKitURISchemeRequest* request) {
+        const gchar* pageURI = webkit_web_view_get_uri(webkit_uri_scheme_request_get_web_view(request));
+        if (pageURI == nullptr || !HasLocalScheme(pageURI)) {
+            return false;
+        }
+#if WEBKIT_CHECK_VERSION(2, 36, 0)
+        SoupMessageHeaders* requestHeaders = webkit_uri_scheme_request_get_http_headers(request);
+        if (requestHeaders != nullptr) {
+            const char* origin = soup_message_headers_get_one(requestHeaders, "Origin");
+            if (origin != nullptr && !HasLocalScheme(origin)) {
+                return false;
+            }
+        }
+#endif
+        return true;
+    }
+
+    std::string RangeHeaderOfRequest(WebKitURISchemeRequest* request) {
+#if WEBKIT_CHECK_VERSION(2, 36, 0)
+        SoupMessageHeaders* requestHeaders = webkit_uri_scheme_request_get_http_headers(request);
+        if (requestHeaders != nullptr) {
+            if (const char* range = soup_message_headers_get_one(requestHeaders, "Range"); range != nullptr) {
+                return range;
+            }
+        }
+#endif
+        return { };
+    }
+
+#if WEBKIT_CHECK_VERSION(2, 36, 0)
+    SoupMessageHeaders* NewLocalResponseHeaders(const LocalResponseOptions& options) {
+        SoupMessageHeaders* responseHeaders = soup_message_headers_new(SOUP_MESSAGE_HEADERS_RESPONSE);
+        if (options.isCrossOriginIsolated) {
+            soup_message_headers_append(responseHeaders, "Cross-Origin-Opener-Policy", "same-origin");
+            soup_message_headers_append(responseHeaders, "Cross-Origin-Embedder-Policy", "require-corp");
+            soup_message_headers_append(responseHeaders, "Cross-Origin-Resource-Policy", "same-origin");
+        }
+        return responseHeaders;
+    }
+
+    // Takes the ownership of responseHeaders
+    void FinishLocalRequestWithResponse(
+        WebKitURISchemeRequest* request, GInputStream* stream, gint64 length, guint status,
+        SoupMessageHeaders* responseHeaders, const LocalResponseOptions& options
+    ) {
+        WebKitURISchemeResponse* response = webkit_uri_scheme_response_new(stream, length);
+        webkit_uri_scheme_response_set_status(response, status, nullptr);
+        webkit_uri_scheme_response_set_content_type(response, options.mimeType.data());
+        webkit_uri_scheme_response_set_http_headers(response, responseHeaders);
+        webkit_uri_scheme_request_finish_with_response(request, response);
+        g_object_unref(response);
+    }
+#endif
+
+    // The bytes are inflated as WebKit reads the stream, and only the compressed bytes are read from the disk.
+    // A stream that cannot be polled is read on a thread of the GIO pool, so a compressed file, read from a GFileInputStream,
+    // is inflated off the UI thread. A compressed entry of a mapped archive is pollable, and inflated on the UI thread one read at a time.
+    void FinishLocalFileRequestWithGzippedStream(WebKitURISchemeRequest* request, GInputStream* compressedStream, const LocalResponseOptions& options) {
+        GZlibDecompressor* decompressor = g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+        GInputStream* stream = g_converter_input_stream_new(compressedStream, G_CONVERTER(decompressor));
+#if WEBKIT_CHECK_VERSION(2, 36, 0)
+        FinishLocalRequestWithResponse(request, stream, -1, SOUP_STATUS_OK, NewLocalResponseHeaders(options), options);
+#else
+        webkit_uri_scheme_request_finish(request, stream, -1, options.mimeType.data());
+#endif
+        g_object_unref(stream);
+        g_object_unref(decompressor);
+    }
+
+    // The stream is the body: the whole file, or only the bytes from rangeStart to rangeEnd if the range is satisfiable.
+    // totalSize is -1 if it is unknown.
+    void FinishLocalFileRequestWithStream(
+        WebKitURISchemeRequest* request, GInputStream* stream, goffset totalSize,
+        LocalRangeResult rangeResult, goffset rangeStart, goffset rangeEnd, const LocalResponseOptions& options
+    ) {
+#if WEBKIT_CHECK_VERSION(2, 36, 0)
+        goffset length = totalSize;
+        guint status = SOUP_STATUS_OK;
+
+        SoupMessageHeaders* responseHeaders = NewLocalResponseHeaders(options);
+        if (totalSize >= 0) {
+            soup_message_headers_append(responseHeaders, "Accept-Ranges", "bytes");
+        }
+        if (rangeResult == LocalRangeResult::SATISFIABLE) {
+            length = rangeEnd - rangeStart + 1;
+            soup_message_headers_set_content_range(responseHeaders, rangeStart, rangeEnd, totalSize);
+            status = SOUP_STATUS_PARTIAL_CONTENT;
+        }
+        else if (rangeResult == LocalRangeResult::UNSATISFIABLE) {
+            gchar* contentRange = g_strdup_printf("bytes */%" G_GOFFSET_FORMAT, totalSize);
+            soup_message_headers_replace(responseHeaders, "Content-Range", contentRange);
+            g_free(contentRange);
+            length = 0;
+            status = SOUP_STATUS_REQUESTED_RANGE_NOT_SATISFIABLE;
+        }
+        if (length >= 0) {
+            soup_message_headers_set_content_length(responseHeaders, length);
+        }
+        FinishLocalRequestWithResponse(request, stream, length, status, responseHeaders, options);
+#else
+        webkit_uri_scheme_request_finish(request, stream, totalSize, options.mimeType.data());
+#endif
+    }
+
+    void FinishLocalFileRequestWithBytes(WebKitURISchemeRequest* request, GBytes* bytes, const LocalResponseOptions& options) {
+        goffset totalSize = g_bytes_get_size(bytes);
+        goffset rangeStart = 0, rangeEnd = 0;
+        LocalRangeResult rangeResult = ParseLocalRange(RangeHeaderOfRequest(request), totalSize, &rangeStart, &rangeEnd);
+
+        GBytes* body;
+        if (rangeResult == LocalRangeResult::SATISFIABLE) {
+            body = g_bytes_new_from_bytes(bytes, rangeStart, rangeEnd - rangeStart + 1);
+        }
+        else if (rangeResult == LocalRangeResult::UNSATISFIABLE) {
+            body = g_bytes_new(nullptr, 0);
+        }
+        else {
+            body = g_bytes_ref(bytes);
+        }
+        GInputStream* stream = g_memory_input_stream_new_from_bytes(body);
+        g_bytes_unref(body);
+
+        FinishLocalFileRequestWithStream(request, stream, totalSize, rangeResult, rangeStart, rangeEnd, options);
+        g_object_unref(stream);
+    }
+
+    void FinishLocalFileRequest(GObject*, GAsyncResult* result, gpointer data) {
+        std::unique_ptr<LocalFileRequest> localFileRequest(static_cast<LocalFileRequest*>(data));
+
+        GError* error = nullptr;
+        auto stream = static_cast<GInputStream*>(g_task_propagate_pointer(G_TASK(result), &error));
+        if (stream == nullptr) {
+            webkit_uri_scheme_request_finish_error(localFileRequest->request, error);
+            g_error_free(error);
+            return;
+        }
+
+        if (localFileRequest->isGzipped) {
+            FinishLocalFileRequestWithGzippedStream(localFileRequest->request, stream, localFileRequest->responseOptions);
+        }
+        else {
+            FinishLocalFileRequestWithStream(
+                localFileRequest->request, stream, localFileRequest->totalSize,
+                localFileRequest->rangeResult, localFileRequest->rangeStart, localFileRequest->rangeEnd,
+                localFileRequest->responseOptions
+            );
+        }
+        g_object_unref(stream);
+    }
 }
 
 namespace DeskGap {
+    const char16_t* WebView::UTF16String::Characters() const {
+        auto jsString = static_cast<JSStringRef>(const_cast<void*>(owner.get()));
+        return reinterpret_cast<const char16_t*>(JSStringGetCharactersPtr(jsString));
+    }
+
+    struct WebContextPartition {
+        std::string name;
+        WebKitWebContext* context;
+        // The live web views of the partition. A new one is related to one of them, so they share a web process.
+        std::vector<WebKitWebView*> gtkWebViews;
+
+        ~WebContextPartition() {
+            Partitions().erase(name);
+            g_object_unref(context);
+        }
 
-    void WebView::Impl::HandleLocalFileUriSchemeRequest(WebKitURISchemeRequest *request, gpointer webView) {
-        const auto& servedPath = static_cast<WebView*>(webView)->impl_->servedPath;
-        if (!servedPath.has_value()) {
+        static std::shared_ptr<WebContextPartition> Open(const std::string& name, WebKitWebContext* (*newContext)()) {
+            std::weak_ptr<WebContextPartition>& openedPartition = Partitions()[name];
+            if (std::shared_ptr<WebContextPartition> partition = openedPartition.lock()) {
+                return partition;
+            }
+            auto partition = std::make_shared<WebContextPartition>();
+            partition->name = name;
+            partition->context = newContext();
+            openedPartition = partition;
+            return partition;
+        }
+    private:
+        static std::unordered_map<std::string, std::weak_ptr<WebContextPartition>>& Partitions() {
+            static std::unordered_map<std::string, std::weak_ptr<WebContextPartition>> partitions;
+            return partitions;
+        }
+    };
+
+    struct AssetArchive {
+        std::string path;
+        GBytes* bytes;
+        AssetArchiveView view;
+        ~AssetArchive() {
+            OpenedArchives().erase(path);
+            g_bytes_unref(bytes);
+        }
+
+        // An archive is mapped once and shared by every WebView serving from it.
+        static std::shared_ptr<AssetArchive> Open(const std::string& path) {
+            if (auto openedArchive = OpenedArchives().find(path); openedArchive != OpenedArchives().end()) {
+                if (std::shared_ptr<AssetArchive> archive = openedArchive->second.lock()) {
+                    return archive;
+                }
+            }
+
+            GError* error = nullptr;
+            GMappedFile* mappedFile = g_mapped_file_new(path.c_str(), FALSE, &error);
+            GlibException::ThrowAndFree(error);
+            GBytes* bytes = g_mapped_file_get_bytes(mappedFile);
+            g_mapped_file_unref(mappedFile);
+
+            gsize size;
+            auto data = static_cast<const uint8_t*>(g_bytes_get_data(bytes, &size));
+            std::optional<AssetArchiveView> view = AssetArchiveView::Parse(data, size);
+            if (!view.has_value()) {
+                g_bytes_unref(bytes);
+                GlibException::ThrowAndFree(g_error_new(G_FILE_ERROR, G_FILE_ERROR_INVAL, "Invalid asset archive: %s", path.c_str()));
+            }
+
+            std::shared_ptr<AssetArchive> archive(new AssetArchive { path, bytes, *view });
+            OpenedArchives()[path] = archive;
+            return archive;
+        }
+
+        void FinishRequest(WebKitURISchemeRequest* request, const AssetArchiveView::Entry& entry, const LocalResponseOptions& options) const {
+            GBytes* entryBytes = g_bytes_new_from_bytes(bytes, entry.offset, entry.size);
+            if (entry.compression == AssetArchiveView::Compression::NONE) {
+                FinishLocalFileRequestWithBytes(request, entryBytes, options);
+            }
+            else {
+                GInputStream* compressedStream = g_memory_input_stream_new_from_bytes(entryBytes);
+                FinishLocalFileRequestWithGzippedStream(request, compressedStream, options);
+                g_object_unref(compressedStream);
+            }
+            g_bytes_unref(entryBytes);
+        }
+    private:
+        // An archive removes itself when it is destroyed, so the archives that are no longer served are not kept.
+        static std::unordered_map<std::string, std::weak_ptr<AssetArchive>>& OpenedArchives() {
+            static std::unordered_map<std::string, std::weak_ptr<AssetArchive>> openedArchives;
+            return openedArchives;
+        }
+    };
+
+    void WebView::Impl::HandleLocalFileUriSchemeRequest(WebKitURISchemeRequest *request, gpointer) {
+        WebView* webView = WebViewOfRequest(request);
+        if (webView == nullptr) {
+            GError *error = g_error_new(WEBKIT_NETWORK_ERROR, WEBKIT_NETWORK_ERROR_CANCELLED, "The web view has been destroyed");
+            webkit_uri_scheme_request_finish_error(request, error);
+            g_error_free(error);
+            return;
+        }
+        const auto& impl = webView->impl_;
+        const auto& servedPath = impl->servedPath;
+        if (!servedPath.has_value() && impl->servedArchive == nullptr) {
             GError *error = g_error_new(WEBKIT_NETWORK_ERROR, 404, "Requesting Local Files Not Allowed");
             webkit_uri_scheme_request_finish_error (request, error);
             g_error_free(error);
@@ -71,39 +495,113 @@ namespace DeskGap {
         const gchar* encodedFilename = urlPath;
         while (*encodedFilename == '/') ++encodedFilename;
 
-        gchar* fileContent;
-        gsize fileSize;
-        std::string fileExtension;
+        std::string fullPath;
+        LocalResponseOptions responseOptions { DeskGap::Mime::kDefaultMimeType, impl->isCrossOriginIsolated };
         {
-            gchar* fullPath;
-            {
-                gchar* filename = g_uri_unescape_string(encodedFilename, nullptr);
+            gchar* filename = g_uri_unescape_string(encodedFilename, nullptr);
 
-                fullPath = g_build_filename(servedPath.value().c_str(), filename, nullptr);
+            if (const char* firstDot = std::strrchr(filename, '.'); firstDot != nullptr) {
+                responseOptions.mimeType = DeskGap::GetMimeTypeOfExtension(firstDot + 1);
+            }
 
-                if (const char* firstDot = std::strrchr(filename, '.'); firstDot != nullptr) {
-                    fileExtension = std::string(firstDot + 1);
-                }
+            if (impl->servedArchive != nullptr) {
+                std::string entryPath = impl->servedArchivePrefix + filename;
                 g_free(filename);
-            }
-            GError* error = nullptr;
-            g_file_get_contents(fullPath, &fileContent, &fileSize, &error);
 
-            if (error != nullptr) {
-                webkit_uri_scheme_request_finish_error(request, error);
-                g_error_free(error);
+                std::optional<AssetArchiveView::Entry> entry = impl->servedArchive->view.Find(entryPath);
+                if (!entry.has_value()) {
+                    GError* error = g_error_new(G_FILE_ERROR, G_FILE_ERROR_NOENT, "No such file in the asset archive: %s", entryPath.c_str());
+                    webkit_uri_scheme_request_finish_error(request, error);
+                    g_error_free(error);
+                    return;
+                }
+                impl->servedArchive->FinishRequest(request, *entry, responseOptions);
                 return;
             }
+
+            gchar* builtPath = g_build_filename(servedPath.value().c_str(), filename, nullptr);
+            fullPath = builtPath;
+            g_free(builtPath);
+            g_free(filename);
+        }
+
+        // The file is opened on a worker thread and read by WebKit as it consumes the stream,
+        // so large files neither block the UI thread nor get copied into memory as a whole.
+        // A "<file>.gz" sibling is preferred unless it is older than the file, so build steps can precompress large bundles.
+        auto localFileRequest = new LocalFileRequest {
+            WEBKIT_URI_SCHEME_REQUEST(g_object_ref(request)),
+            std::move(fullPath),
+            responseOptions,
+            RangeHeaderOfRequest(request)
+        };
+        GTask* task = g_task_new(nullptr, nullptr, FinishLocalFileRequest, localFileRequest);
+        g_task_set_task_data(task, localFileRequest, nullptr);
+        g_task_run_in_thread(task, OpenLocalFileInThread);
+        g_object_unref(task);
+    }
+
+
+    void WebView::Impl::HandleIpcUriSchemeRequest(WebKitURISchemeRequest *request, gpointer) {
+        WebView* webView = WebViewOfRequest(request);
+        if (webView == nullptr) {
+            GError *error = g_error_new(WEBKIT_NETWORK_ERROR, WEBKIT_NETWORK_ERROR_CANCELLED, "The web view has been destroyed");
+            webkit_uri_scheme_request_finish_error(request, error);
+            g_error_free(error);
+            return;
+        }
+
+        // The queue is drained only by the top-level local page, which is the only one the preload script runs in.
+        // A frame of another origin gets an empty response and leaves the messages queued.
+        // While a remote page is committed, nothing is queued.
+        if (!IsRequestFromLocalPage(request)) {
+            GInputStream* emptyStream = g_memory_input_stream_new();
+            webkit_uri_scheme_request_finish(request, emptyStream, 0, "application/octet-stream");
+            g_object_unref(emptyStream);
+            return;
+        }
+
+        // Every pending message is framed as a little-endian uint32 length followed by the payload.
+        // The payloads are added to the stream as they are, so they are not copied again.
+        std::deque<GBytes*>& pendingMessages = webView->impl_->pendingBinaryMessages;
+
+        GMemoryInputStream* stream = G_MEMORY_INPUT_STREAM(g_memory_input_stream_new());
+        gint64 streamLength = 0;
+        for (GBytes* message: pendingMessages) {
+            gsize messageSize = g_bytes_get_size(message);
+            guint32 header = GUINT32_TO_LE(static_cast<guint32>(messageSize));
+
+            GBytes* headerBytes = g_bytes_new(&header, sizeof(header));
+            g_memory_input_stream_add_bytes(stream, headerBytes);
+            g_bytes_unref(headerBytes);
+
+            g_memory_input_stream_add_bytes(stream, message);
+            g_bytes_unref(message);
+
+            streamLength += sizeof(header) + messageSize;
         }
+        pendingMessages.clear();
 
-        GInputStream *stream = g_memory_input_stream_new_from_data(fileContent, fileSize, g_free);
-        webkit_uri_scheme_request_finish(request, stream, fileSize, DeskGap::GetMimeTypeOfExtension(fileExtension).c_str());
+        webkit_uri_scheme_request_finish(request, G_INPUT_STREAM(stream), streamLength, "application/octet-stream");
         g_object_unref(stream);
     }
 
+    void WebView::Impl::DropPendingBinaryMessages() {
+        for (GBytes* message: pendingBinaryMessages) {
+            g_bytes_unref(message);
+        }
+        pendingBinaryMessages.clear();
+    }
 
     void WebView::Impl::HandleLoadChanged(GtkWidget*, WebKitLoadEvent loadEvent, WebView* webView) {
         switch (loadEvent) {
+        case WEBKIT_LOAD_COMMITTED: {
+            const gchar* uri = webkit_web_view_get_uri(webView->impl_->gtkWebView);
+            webView->impl_->isCommittedPageRemote = uri == nullptr || !HasLocalScheme(uri);
+            if (webView->impl_->isCommittedPageRemote) {
+                webView->impl_->DropPendingBinaryMessages();
+            }
+            break;
+        }
         case WEBKIT_LOAD_FINISHED:
             webView->impl_->callbacks.didFinishLoad();
             break;
@@ -112,18 +610,85 @@ namespace DeskGap {
         }
     }
 
-    WebView::WebView(EventCallbacks&& callbacks, const std::string& preloadScriptString): impl_(std::make_unique<Impl>()) {
+    WebKitWebContext* WebView::Impl::NewWebContext() {
+        WebKitWebContext* context = webkit_web_context_new();
+        webkit_web_context_register_uri_scheme(
+            context,
+            localURLScheme, Impl::HandleLocalFileUriSchemeRequest,
+            nullptr, nullptr
+        );
+
+        webkit_web_context_register_uri_scheme(
+            context,
+            ipcURLScheme, Impl::HandleIpcUriSchemeRequest,
+            nullptr, nullptr
+        );
+        WebKitSecurityManager* securityManager = webkit_web_context_get_security_manager(context);
+        // The local scheme is only made secure by SetCrossOriginIsolated
+        webkit_security_manager_register_uri_scheme_as_secure(securityManager, ipcURLScheme);
+        webkit_security_manager_register_uri_scheme_as_cors_enabled(securityManager, ipcURLScheme);
+
+        switch (contextOptions.cacheModel) {
+        case ContextOptions::CacheModel::DOCUMENT_VIEWER:
+            webkit_web_context_set_cache_model(context, WEBKIT_CACHE_MODEL_DOCUMENT_VIEWER);
+            break;
+        case ContextOptions::CacheModel::DOCUMENT_BROWSER:
+            webkit_web_context_set_cache_model(context, WEBKIT_CACHE_MODEL_DOCUMENT_BROWSER);
+            break;
+        case ContextOptions::CacheModel::WEB_BROWSER:
+            webkit_web_context_set_cache_model(context, WEBKIT_CACHE_MODEL_WEB_BROWSER);
+            break;
+        }
+
+    #if !WEBKIT_CHECK_VERSION(2, 26, 0)
+        if (contextOptions.webProcessCountLimit != 0) {
+            webkit_web_context_set_process_model(context, WEBKIT_PROCESS_MODEL_MULTIPLE_SECONDARY_PROCESSES);
+            webkit_web_context_set_web_process_count_limit(context, contextOptions.webProcessCountLimit);
+        }
+    #endif
+        return context;
+    }
+
+    void WebView::SetContextOptions(const ContextOptions& options) {
+        contextOptions = options;
+    }
+
+    WebView::WebView(EventCallbacks&& callbacks, const std::string& preloadScriptString):
+        WebView(std::move(callbacks), preloadScriptString, std::string()) { }
+
+    WebView::WebView(EventCallbacks&& callbacks, const std::string& preloadScriptString, const std::string& partition): impl_(std::make_unique<Impl>()) {
         impl_->callbacks = std::move(callbacks);
         {
-            WebKitWebContext* context = webkit_web_context_new();
-            webkit_web_context_register_uri_scheme(
-                context,
-                localURLScheme, Impl::HandleLocalFileUriSchemeRequest,
-                this, nullptr
-            );
+            WebKitWebContext* context;
+            WebKitWebView* relatedView = nullptr;
+            if (partition.empty()) {
+                context = Impl::NewWebContext();
+            }
+            else {
+                impl_->partition = WebContextPartition::Open(partition, Impl::NewWebContext);
+                context = WEBKIT_WEB_CONTEXT(g_object_ref(impl_->partition->context));
+                if (!impl_->partition->gtkWebViews.empty()) {
+                    relatedView = impl_->partition->gtkWebViews.front();
+                }
+            }
 
-            impl_->gtkWebView = WEBKIT_WEB_VIEW(g_object_ref_sink(webkit_web_view_new_with_context(context)));
+            // Every view has its own user content manager even if it is related to another one,
+            // because the script message handlers below are connected per view.
+            WebKitUserContentManager* manager = webkit_user_content_manager_new();
+            impl_->gtkWebView = WEBKIT_WEB_VIEW(g_object_ref_sink(g_object_new(
+                WEBKIT_TYPE_WEB_VIEW,
+                "web-context", context,
+                "related-view", relatedView,
+                "user-content-manager", manager,
+                nullptr
+            )));
+            g_object_unref(manager);
             g_object_unref(context);
+
+            g_object_set_data(G_OBJECT(impl_->gtkWebView), webViewDataKey, this);
+            if (impl_->partition != nullptr) {
+                impl_->partition->gtkWebViews.push_back(impl_->gtkWebView);
+            }
         }
 
         {
@@ -155,6 +720,14 @@ namespace DeskGap {
             );
             webkit_user_content_manager_register_script_message_handler(manager, "stringMessage");
 
+            impl_->scriptBinaryMessageConnection = g_signal_connect(
+                manager,
+                "script-message-received::binaryMessage",
+                G_CALLBACK(Impl::HandleScriptBinaryMessage),
+                this
+            );
+            webkit_user_content_manager_register_script_message_handler(manager, "binaryMessage");
+
             {
                 WebKitUserScript* preloadUserScript = webkit_user_script_new(
                     preloadScript.c_str(),
@@ -210,10 +783,18 @@ namespace DeskGap {
         lastLeftMouseDownEvent.reset();
     }
     void WebView::Impl::HandleScriptStringMessage(WebKitUserContentManager*, WebKitJavascriptResult* jsResult, WebView* webView) {
-        std::optional<std::string> resultMessage = std::move(jsResultToString(jsResult));
+        std::optional<UTF16String> resultMessage = jsResultToUTF16String(jsResult);
+        webkit_javascript_result_unref(jsResult);
+
+        webView->impl_->callbacks.onUTF16StringMessage(std::move(*resultMessage));
+    }
+    void WebView::Impl::HandleScriptBinaryMessage(WebKitUserContentManager*, WebKitJavascriptResult* jsResult, WebView* webView) {
+        std::optional<std::vector<uint8_t>> resultMessage = jsResultToBytes(jsResult);
         webkit_javascript_result_unref(jsResult);
 
-        webView->impl_->callbacks.onStringMessage(std::move(*resultMessage));
+        if (resultMessage.has_value()) {
+            webView->impl_->callbacks.onBinaryMessage(std::move(*resultMessage));
+        }
     }
     gboolean WebView::Impl::HandleButtonPressEvent(GtkWidget*, GdkEventButton* event, WebView* webView) {
         if (event->button == 1 && event->type == GDK_BUTTON_PRESS) {
@@ -241,25 +822,68 @@ namespace DeskGap {
         WebKitUserContentManager* manager = webkit_web_view_get_user_content_manager(impl_->gtkWebView);
         for (gulong connection: {
             impl_->scriptStringMessageConnection,
+            impl_->scriptBinaryMessageConnection,
             impl_->scriptWindowDragConnection
         }) {
             g_signal_handler_disconnect(manager, connection);
         }
 
+        impl_->DropPendingBinaryMessages();
+
+        // The widget may outlive this object while it is still in a window
+        g_object_set_data(G_OBJECT(impl_->gtkWebView), webViewDataKey, nullptr);
+        if (impl_->partition != nullptr) {
+            std::vector<WebKitWebView*>& gtkWebViews = impl_->partition->gtkWebViews;
+            gtkWebViews.erase(std::find(gtkWebViews.begin(), gtkWebViews.end(), impl_->gtkWebView));
+        }
+
         g_object_unref(impl_->gtkWebView);
     }
 
     void WebView::LoadLocalFile(const std::string& path) {
         const char* cpath = path.c_str();
-        gchar* folderPath = g_path_get_dirname(cpath);
+        std::string folderPath;
+        {
+            gchar* dirname = g_path_get_dirname(cpath);
+            folderPath = dirname;
+            g_free(dirname);
+        }
+
+        std::shared_ptr<AssetArchive> archive;
+        std::string archivePrefix;
+        if (!g_file_test(folderPath.c_str(), G_FILE_TEST_IS_DIR)) {
+            // Look for an archive among the ancestors, so "assets.dgpack/pages/index.html" is served from
+            // the "pages/index.html" entry of "assets.dgpack", and relative URLs resolve inside the archive.
+            std::string archivePath = folderPath;
+            while (!archivePath.empty() && archivePath != "/" && archivePath != ".") {
+                if (g_str_has_suffix(archivePath.c_str(), assetArchiveExtension) && g_file_test(archivePath.c_str(), G_FILE_TEST_IS_REGULAR)) {
+                    archive = AssetArchive::Open(archivePath);
+                    break;
+                }
+                gchar* parentPath = g_path_get_dirname(archivePath.c_str());
+                gchar* basename = g_path_get_basename(archivePath.c_str());
+                archivePrefix = std::string(basename) + "/" + archivePrefix;
+                archivePath = parentPath;
+                g_free(basename);
+                g_free(parentPath);
+            }
+        }
+
         gchar* filename = g_path_get_basename(cpath);
         gchar* encodedFilename = g_uri_escape_string(filename, nullptr, false);
         gchar* url = g_strdup_printf("%s://host/%s", localURLScheme, encodedFilename);
 
-        impl_->servedPath.emplace(folderPath);
+        if (archive != nullptr) {
+            impl_->servedPath.reset();
+            impl_->servedArchive = std::move(archive);
+            impl_->servedArchivePrefix = std::move(archivePrefix);
+        }
+        else {
+            impl_->servedPath.emplace(folderPath);
+            impl_->servedArchive.reset();
+        }
         webkit_web_view_load_uri(impl_->gtkWebView, url);
 
-        g_free(folderPath);
         g_free(filename);
         g_free(encodedFilename);
         g_free(url);
@@ -272,6 +896,7 @@ namespace DeskGap {
         const std::optional<std::string>& body
     ) {
         impl_->servedPath.reset();
+        impl_->servedArchive.reset();
 
         WebKitURIRequest* request = webkit_uri_request_new(urlString.c_str());
 
@@ -290,10 +915,43 @@ namespace DeskGap {
         webkit_settings_set_enable_developer_extras(settings, enabled);
     }
 
+    void WebView::SetCrossOriginIsolated(bool isolated) {
+        impl_->isCrossOriginIsolated = isolated;
+        if (isolated) {
+            // Cross-origin isolation is only granted to secure contexts. It cannot be undone,
+            // and applies to every view in the partition of this one.
+            WebKitWebContext* context = webkit_web_view_get_context(impl_->gtkWebView);
+            WebKitSecurityManager* securityManager = webkit_web_context_get_security_manager(context);
+            webkit_security_manager_register_uri_scheme_as_secure(securityManager, localURLScheme);
+        }
+    }
+
     void WebView::Reload() {
         webkit_web_view_reload_bypass_cache(impl_->gtkWebView);
     }
 
+    void WebView::PostBinaryMessage(std::vector<uint8_t>&& data) {
+        if (impl_->isCommittedPageRemote) {
+            return;
+        }
+        auto messageData = new std::vector<uint8_t>(std::move(data));
+        GBytes* message = g_bytes_new_with_free_func(
+            messageData->data(), messageData->size(),
+            [](gpointer messageData) {
+                delete static_cast<std::vector<uint8_t>*>(messageData);
+            },
+            messageData
+        );
+
+        // The page drains the whole queue in one request, so it only needs to be woken up
+        // when the queue becomes non-empty.
+        bool wasEmpty = impl_->pendingBinaryMessages.empty();
+        impl_->pendingBinaryMessages.push_back(message);
+        if (wasEmpty) {
+            webkit_web_view_run_javascript(impl_->gtkWebView, binaryMessagesAvailableScript, nullptr, nullptr, nullptr);
+        }
+    }
+
     void WebView::ExecuteJavaScript(const std::string& scriptString, std::optional<JavaScriptExecutionCallback>&& optionalCallback) {
         if (!optionalCallback.has_value()) {
             webkit_web_view_run_javascript(impl_->gtkWebView, scriptString.c_str(), nullptr, nullptr, nullptr);
@@ -1,18 +1,39 @@
 #ifndef gtk_webview_impl_h
 #define gtk_webview_impl_h
 
+#include <deque>
+#include <memory>
 #include <optional>
 #include <webkit2/webkit2.h>
 
 #include "webview.hpp"
 
 namespace DeskGap {
+    struct AssetArchive;
+    struct WebContextPartition;
+
     struct WebView::Impl {
 		WebKitWebView* gtkWebView;
+		// Null if the web view has a context of its own
+		std::shared_ptr<WebContextPartition> partition;
 		WebView::EventCallbacks callbacks;
 		std::optional<std::string> servedPath;
 
+		// Set instead of servedPath when the loaded file is inside a .dgpack archive
+		std::shared_ptr<AssetArchive> servedArchive;
+		std::string servedArchivePrefix;
+		bool isCrossOriginIsolated = false;
+
+		// Creates a context with the deskgap schemes registered, and the options from WebView::SetContextOptions
+		static WebKitWebContext* NewWebContext();
+
 		static void HandleLocalFileUriSchemeRequest(WebKitURISchemeRequest *request, gpointer);
+
+		std::deque<GBytes*> pendingBinaryMessages;
+		// Only a local page drains the binary messages, so they are dropped while another page is committed
+		bool isCommittedPageRemote = false;
+		void DropPendingBinaryMessages();
+		static void HandleIpcUriSchemeRequest(WebKitURISchemeRequest *request, gpointer);
 		
 		gulong loadChangedConnection;
 		static void HandleLoadChanged(GtkWidget*, WebKitLoadEvent, WebView*);
@@ -30,6 +51,9 @@ namespace DeskGap {
 
 		gulong scriptStringMessageConnection;
 		static void HandleScriptStringMessage(WebKitUserContentManager*, WebKitJavascriptResult*, WebView*);
+
+		gulong scriptBinaryMessageConnection;
+		static void HandleScriptBinaryMessage(WebKitUserContentManager*, WebKitJavascriptResult*, WebView*);
 		
 		gulong titleChangedConnection;
 		static void HandleTitleChanged(GObject*, GParamSpec* pspec, WebView*);
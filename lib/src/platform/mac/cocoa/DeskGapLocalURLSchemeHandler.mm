@@ -37,7 +37,7 @@ namespace {
         return respond404(urlSchemeTask);
     }
 
-    NSString* mimeType = NSStr(DeskGap::GetMimeTypeOfExtension(CXXStr(urlSchemeTask.request.URL.pathExtension)));
+    NSString* mimeType = @(DeskGap::GetMimeTypeOfExtension(urlSchemeTask.request.URL.pathExtension.UTF8String).data());
     
     [urlSchemeTask didReceiveResponse: [[NSURLResponse alloc]
         initWithURL: urlSchemeTask.request.URL
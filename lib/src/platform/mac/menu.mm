@@ -31,6 +31,32 @@
 
 @end
 
+@interface DeskGapMenuDelegate: NSObject<NSMenuDelegate>
+-(instancetype)initWithCallbacks: (DeskGap::Menu::EventCallbacks&&) callbacks;
+@end
+
+@implementation DeskGapMenuDelegate {
+    DeskGap::Menu::EventCallbacks _callbacks;
+}
+
+-(instancetype)initWithCallbacks: (DeskGap::Menu::EventCallbacks&&) callbacks {
+    self = [super init];
+    if (self) {
+        _callbacks = std::move(callbacks);
+    }
+    return self;
+}
+
+- (void)menuWillOpen:(NSMenu *)menu {
+    if (_callbacks.onShow) _callbacks.onShow();
+}
+
+- (void)menuDidClose:(NSMenu *)menu {
+    if (_callbacks.onHide) _callbacks.onHide();
+}
+
+@end
+
 namespace DeskGap {
     MenuItem::MenuItem(const std::string& role, const Type& type, const Menu* submenu, EventCallbacks&& eventCallbacks): impl_(std::make_unique<Impl>()) {
         impl_->role = role;
@@ -146,13 +172,30 @@ namespace DeskGap {
 
     MenuItem::~MenuItem() = default;
 
-    Menu::Menu(const Type& type): impl_(std::make_unique<Impl>()) {
+    Menu::Menu(const Type& type, EventCallbacks&& callbacks): impl_(std::make_unique<Impl>()) {
         impl_->ns_menu = [[NSMenu alloc] init];
+        if (callbacks.onShow || callbacks.onHide) {
+            // NSMenu does not retain its delegate
+            impl_->delegate = [[DeskGapMenuDelegate alloc] initWithCallbacks: std::move(callbacks)];
+            [impl_->ns_menu setDelegate: impl_->delegate];
+        }
     }
 
     void Menu::AppendItem(const MenuItem& menuItem) {
         [impl_->ns_menu addItem: menuItem.impl_->ns_menu_item];
     }
 
+    void Menu::InsertItem(const MenuItem& menuItem, size_t index) {
+        NSInteger itemCount = [impl_->ns_menu numberOfItems];
+        NSInteger position = index < static_cast<size_t>(itemCount) ? static_cast<NSInteger>(index) : itemCount;
+        [impl_->ns_menu insertItem: menuItem.impl_->ns_menu_item atIndex: position];
+    }
+
+    void Menu::RemoveItem(const MenuItem& menuItem) {
+        if ([menuItem.impl_->ns_menu_item menu] == impl_->ns_menu) {
+            [impl_->ns_menu removeItem: menuItem.impl_->ns_menu_item];
+        }
+    }
+
     Menu::~Menu() = default;
 }
@@ -14,6 +14,7 @@ namespace DeskGap {
     
     struct Menu::Impl {
         NSMenu* ns_menu;
+        id delegate;
     };
 }
 
@@ -55,6 +55,11 @@ namespace DeskGap {
                             browserWindow->impl_->callbacks.onClose();
                             return 0;
                         }
+                        case WM_INITMENUPOPUP:
+                        case WM_UNINITMENUPOPUP: {
+                            Menu::Impl::HandlePopupMessage(msg, (HMENU)wp);
+                            break;
+                        }
                         case WM_SIZE: {
                             RECT rect { };
                             GetClientRect(hwnd, &rect);
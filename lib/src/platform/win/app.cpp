@@ -1,6 +1,7 @@
 #include "app.hpp"
 #include "./util/wstring_utf8.h"
 #include "dispatch_wnd.hpp"
+#include "menu_impl.h"
 #include "process_singleton.hpp"
 #include "util/reg_key.hpp"
 #include "util/ui_theme_host.hpp"
@@ -167,6 +168,9 @@ namespace DeskGap {
                 return 0;
             } else if (msg == DG_TRAY_MSG) {
                 return DeskGap::OnTrayClick(wp, lp);
+            } else if (msg == WM_INITMENUPOPUP || msg == WM_UNINITMENUPOPUP) {
+                // The tray menus are owned by this window
+                Menu::Impl::HandlePopupMessage(msg, (HMENU)wp);
             } else if (msg == WM_COPYDATA) {
                 // Handle the WM_COPYDATA message from another process
                 const COPYDATASTRUCT *cds = reinterpret_cast<COPYDATASTRUCT *>(lp);
@@ -196,12 +200,9 @@ namespace DeskGap {
         BOOL res;
         while ((res = GetMessageW(&msg, nullptr, 0, 0)) != -1) {
             if (msg.message == WM_MENUCOMMAND) {
-                MENUINFO info{};
-                info.cbSize = sizeof(info);
-                info.fMask = MIM_MENUDATA;
-                GetMenuInfo((HMENU)msg.lParam, &info);
-                auto clickHandlers = reinterpret_cast<std::vector<std::function<void()> *> *>(info.dwMenuData);
-                (*((*clickHandlers)[msg.wParam]))();
+                if (Menu::Impl* menu = Menu::Impl::FromHMenu((HMENU)msg.lParam); menu != nullptr) {
+                    (*(menu->clickHandlers[msg.wParam]))();
+                }
             } else if (msg.message == WM_QUIT) {
                 return;
             } else if (msg.hwnd) {
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <unordered_map>
@@ -31,7 +32,7 @@ namespace {
 }
 
 namespace DeskGap {
-    void MenuItem::Impl::AppendTo(HMENU parentHMenu) {
+    void MenuItem::Impl::InsertTo(HMENU parentHMenu, UINT position) {
         parentHMenu_.emplace(parentHMenu);
         UINT flags = MF_ENABLED;
         if (type == Type::SUBMENU) {
@@ -43,7 +44,7 @@ namespace DeskGap {
         else {
             flags |= MF_STRING;
         }
-        AppendMenuW(parentHMenu, flags, identifier, L"");
+        InsertMenuW(parentHMenu, position, flags | MF_BYPOSITION, identifier, L"");
 
         this->UpdateInfo();
     }
@@ -139,8 +140,9 @@ namespace DeskGap {
 
     MenuItem::~MenuItem() = default;
 
-    Menu::Menu(const Type& type): impl_(std::make_unique<Impl>()) {
+    Menu::Menu(const Type& type, EventCallbacks&& callbacks): impl_(std::make_unique<Impl>()) {
         impl_->type = type;
+        impl_->callbacks = std::move(callbacks);
         if (type == Type::MAIN) {
             impl_->hmenu = CreateMenu();
         }
@@ -153,11 +155,29 @@ namespace DeskGap {
         info.cbSize = sizeof(info);
         info.fMask = MIM_STYLE | MIM_MENUDATA;
         info.dwStyle = MNS_NOTIFYBYPOS;
-        info.dwMenuData = reinterpret_cast<ULONG_PTR>(&(impl_->clickHandlers));
+        info.dwMenuData = reinterpret_cast<ULONG_PTR>(impl_.get());
         SetMenuInfo(impl_->hmenu, &info);
     }
 
+    Menu::Impl* Menu::Impl::FromHMenu(HMENU hmenu) {
+        MENUINFO info { };
+        info.cbSize = sizeof(info);
+        info.fMask = MIM_MENUDATA;
+        if (!GetMenuInfo(hmenu, &info)) return nullptr;
+        return reinterpret_cast<Impl*>(info.dwMenuData);
+    }
+
+    void Menu::Impl::HandlePopupMessage(UINT msg, HMENU hmenu) {
+        Impl* impl = FromHMenu(hmenu);
+        if (impl == nullptr) return;
+        const std::function<void()>& callback = msg == WM_INITMENUPOPUP ? impl->callbacks.onShow : impl->callbacks.onHide;
+        if (callback) {
+            callback();
+        }
+    }
+
     void Menu::Impl::SetWindowWnd(HWND windowWnd) {
+        this->windowWnd = windowWnd;
         for (const MenuItem* item: items) {
             item->impl_->windowWnd = windowWnd;
         }
@@ -166,7 +186,36 @@ namespace DeskGap {
     void Menu::AppendItem(const MenuItem& menuItem) {
         impl_->items.push_back(&menuItem);
         impl_->clickHandlers.push_back(&(menuItem.impl_->callbacks.onClick));
-        menuItem.impl_->AppendTo(impl_->hmenu);
+        menuItem.impl_->InsertTo(impl_->hmenu, UINT(-1));
+    }
+
+    void Menu::InsertItem(const MenuItem& menuItem, size_t index) {
+        index = std::min(index, impl_->items.size());
+        //The click handlers are looked up by position (MNS_NOTIFYBYPOS), so they are kept in the order of the items
+        impl_->items.insert(impl_->items.begin() + index, &menuItem);
+        impl_->clickHandlers.insert(impl_->clickHandlers.begin() + index, &(menuItem.impl_->callbacks.onClick));
+        menuItem.impl_->windowWnd = impl_->windowWnd;
+        menuItem.impl_->InsertTo(impl_->hmenu, UINT(index));
+        impl_->Redraw();
+    }
+
+    void Menu::RemoveItem(const MenuItem& menuItem) {
+        auto it = std::find(impl_->items.begin(), impl_->items.end(), &menuItem);
+        if (it == impl_->items.end()) return;
+        size_t index = it - impl_->items.begin();
+        impl_->items.erase(it);
+        impl_->clickHandlers.erase(impl_->clickHandlers.begin() + index);
+        //RemoveMenu, unlike DeleteMenu, does not destroy the submenu of the item
+        RemoveMenu(impl_->hmenu, UINT(index), MF_BYPOSITION);
+        menuItem.impl_->parentHMenu_.reset();
+        menuItem.impl_->windowWnd = nullptr;
+        impl_->Redraw();
+    }
+
+    void Menu::Impl::Redraw() {
+        if (windowWnd != nullptr) {
+            DrawMenuBar(windowWnd);
+        }
     }
 
     Menu::~Menu() {
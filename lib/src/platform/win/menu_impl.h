@@ -27,17 +27,25 @@ namespace DeskGap {
 
         std::optional<HMENU> parentHMenu_;
 
-        void AppendTo(HMENU parentHMenu);
+        // position is an index, or -1 to append
+        void InsertTo(HMENU parentHMenu, UINT position);
     };
     
     struct Menu::Impl {
         Type type;
-        HWND windowWnd;
+        // The window whose menu bar this is, to be redrawn after the items change
+        HWND windowWnd = nullptr;
         
         std::vector<std::function<void()>*> clickHandlers;
         std::vector<const MenuItem*> items;
+        Menu::EventCallbacks callbacks;
+        // Handles WM_INITMENUPOPUP and WM_UNINITMENUPOPUP, sent to the window that owns the menu
+        static void HandlePopupMessage(UINT msg, HMENU hmenu);
+        // The menu data of every hmenu points to its Menu::Impl
+        static Impl* FromHMenu(HMENU hmenu);
         void SetWindowWnd(HWND windowWnd);
         HMENU hmenu;
+        void Redraw();
     };
 
 }
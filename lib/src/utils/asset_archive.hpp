@@ -0,0 +1,108 @@
+#ifndef DESKGAP_UTILS_ASSET_ARCHIVE_HPP
+#define DESKGAP_UTILS_ASSET_ARCHIVE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+namespace DeskGap {
+    // A read-only view of an archive written by node/npm/pack.js.
+    // It does not own the bytes, which are usually a memory-mapped file.
+    class AssetArchiveView {
+    public:
+        enum class Compression: uint32_t {
+            NONE = 0,
+            GZIP = 1
+        };
+        struct Entry {
+            size_t offset;
+            size_t size;
+            Compression compression;
+        };
+    private:
+        static constexpr uint32_t kVersion = 1;
+        static constexpr size_t kHeaderSize = 16;
+        static constexpr size_t kEntrySize = 32;
+
+        const uint8_t* data_;
+        uint32_t entryCount_;
+        const char* pathTable_;
+
+        AssetArchiveView(const uint8_t* data, uint32_t entryCount, const char* pathTable):
+            data_(data), entryCount_(entryCount), pathTable_(pathTable) { }
+
+        static uint32_t ReadUInt32(const uint8_t* bytes) {
+            return static_cast<uint32_t>(bytes[0]) |
+                static_cast<uint32_t>(bytes[1]) << 8 |
+                static_cast<uint32_t>(bytes[2]) << 16 |
+                static_cast<uint32_t>(bytes[3]) << 24;
+        }
+        static uint64_t ReadUInt64(const uint8_t* bytes) {
+            return static_cast<uint64_t>(ReadUInt32(bytes)) | static_cast<uint64_t>(ReadUInt32(bytes + 4)) << 32;
+        }
+
+        const uint8_t* EntryAt(uint32_t index) const {
+            return data_ + kHeaderSize + kEntrySize * index;
+        }
+        std::string_view PathAt(uint32_t index) const {
+            const uint8_t* entry = EntryAt(index);
+            return std::string_view(pathTable_ + ReadUInt32(entry), ReadUInt32(entry + 4));
+        }
+    public:
+        // Returns std::nullopt if the bytes are not a well-formed archive.
+        // Every entry is checked here, so lookups do not need to check bounds again.
+        static std::optional<AssetArchiveView> Parse(const uint8_t* data, size_t size) {
+            if (size < kHeaderSize || std::memcmp(data, "DGPK", 4) != 0 || ReadUInt32(data + 4) != kVersion) {
+                return std::nullopt;
+            }
+            uint64_t entryCount = ReadUInt32(data + 8);
+            uint64_t pathTableSize = ReadUInt32(data + 12);
+            uint64_t pathTableOffset = kHeaderSize + kEntrySize * entryCount;
+            if (pathTableOffset + pathTableSize > size) {
+                return std::nullopt;
+            }
+
+            AssetArchiveView view(data, static_cast<uint32_t>(entryCount), reinterpret_cast<const char*>(data + pathTableOffset));
+            for (uint32_t i = 0; i < entryCount; ++i) {
+                const uint8_t* entry = view.EntryAt(i);
+                uint64_t pathEnd = static_cast<uint64_t>(ReadUInt32(entry)) + ReadUInt32(entry + 4);
+                uint64_t dataOffset = ReadUInt64(entry + 8);
+                uint64_t dataSize = ReadUInt64(entry + 16);
+                uint32_t compression = ReadUInt32(entry + 24);
+                if (pathEnd > pathTableSize || dataOffset > size || dataSize > size - dataOffset || compression > 1) {
+                    return std::nullopt;
+                }
+                if (i > 0 && !(view.PathAt(i - 1) < view.PathAt(i))) {
+                    return std::nullopt;
+                }
+            }
+            return view;
+        }
+
+        std::optional<Entry> Find(std::string_view path) const {
+            uint32_t low = 0, high = entryCount_;
+            while (low < high) {
+                uint32_t middle = low + (high - low) / 2;
+                int comparison = PathAt(middle).compare(path);
+                if (comparison == 0) {
+                    const uint8_t* entry = EntryAt(middle);
+                    return Entry {
+                        static_cast<size_t>(ReadUInt64(entry + 8)),
+                        static_cast<size_t>(ReadUInt64(entry + 16)),
+                        static_cast<Compression>(ReadUInt32(entry + 24))
+                    };
+                }
+                if (comparison < 0) {
+                    low = middle + 1;
+                }
+                else {
+                    high = middle;
+                }
+            }
+            return std::nullopt;
+        }
+    };
+}
+
+#endif
@@ -1,48 +1,159 @@
 #ifndef DESKGAP_UTILS_MINE_H
 #define DESKGAP_UTILS_MINE_H
 
-#include <unordered_map>
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
 
 namespace DeskGap {
-    inline std::string GetMimeTypeOfExtension(const std::string& extension) {
-        static std::unordered_map<std::string, std::string> mimeTypesByExtension {
-            { "txt", "text/plain" },
+    namespace Mime {
+        struct Entry {
+            std::string_view extension;
+            std::string_view mimeType;
+        };
+
+        // Extensions are lowercase. Every mime type is a string literal, so the views are null-terminated.
+        inline constexpr Entry kEntries[] {
+            { "aac", "audio/aac" },
+            { "apng", "image/apng" },
+            { "avif", "image/avif" },
+            { "bin", "application/octet-stream" },
             { "bmp", "image/bmp" },
+            { "cjs", "text/javascript" },
             { "css", "text/css" },
-            { "git", "image/gif" },
+            { "csv", "text/csv" },
+            { "eot", "application/vnd.ms-fontobject" },
+            { "epub", "application/epub+zip" },
+            { "flac", "audio/flac" },
+            { "gif", "image/gif" },
+            { "gz", "application/gzip" },
+            { "heic", "image/heic" },
+            { "heif", "image/heif" },
             { "htm", "text/html" },
             { "html", "text/html" },
             { "ico", "image/vnd.microsoft.icon" },
-            { "jpg", "image/jpeg" },
+            { "ics", "text/calendar" },
             { "jpeg", "image/jpeg" },
+            { "jpg", "image/jpeg" },
             { "js", "text/javascript" },
             { "json", "application/json" },
-            { "mjs", "application/javascript" },
+            { "jsonld", "application/ld+json" },
+            { "jxl", "image/jxl" },
+            { "m3u8", "application/vnd.apple.mpegurl" },
+            { "m4a", "audio/mp4" },
+            { "m4v", "video/mp4" },
+            { "manifest", "application/manifest+json" },
+            { "map", "application/json" },
+            { "md", "text/markdown" },
+            { "mid", "audio/midi" },
+            { "midi", "audio/midi" },
+            { "mjs", "text/javascript" },
+            { "mov", "video/quicktime" },
             { "mp3", "audio/mpeg" },
+            { "mp4", "video/mp4" },
+            { "mpd", "application/dash+xml" },
             { "mpeg", "video/mpeg" },
-            { "png", "image/png" },
+            { "mpg", "video/mpeg" },
+            { "oga", "audio/ogg" },
+            { "ogg", "audio/ogg" },
+            { "ogv", "video/ogg" },
+            { "opus", "audio/opus" },
+            { "otf", "font/otf" },
             { "pdf", "application/pdf" },
+            { "png", "image/png" },
+            { "rtf", "application/rtf" },
             { "svg", "image/svg+xml" },
+            { "svgz", "image/svg+xml" },
+            { "tar", "application/x-tar" },
             { "tif", "image/tiff" },
             { "tiff", "image/tiff" },
-            { "tff", "font/ttf" },
+            // MPEG transport stream, the segments of HLS playlists. TypeScript sources are not served to pages.
+            { "ts", "video/mp2t" },
+            { "ttc", "font/collection" },
+            { "ttf", "font/ttf" },
+            { "tsv", "text/tab-separated-values" },
+            { "txt", "text/plain" },
+            { "vtt", "text/vtt" },
+            { "wasm", "application/wasm" },
             { "wav", "audio/wav" },
             { "weba", "audio/webm" },
             { "webm", "video/webm" },
+            { "webmanifest", "application/manifest+json" },
             { "webp", "image/webp" },
             { "woff", "font/woff" },
             { "woff2", "font/woff2" },
             { "xhtml", "application/xhtml+xml" },
             { "xml", "application/xml" },
+            { "xsl", "application/xslt+xml" },
+            { "yaml", "application/yaml" },
+            { "yml", "application/yaml" },
+            { "zip", "application/zip" },
         };
+        inline constexpr std::string_view kDefaultMimeType = "application/octet-stream";
 
-        auto findResult = mimeTypesByExtension.find(extension);
-        if (findResult == mimeTypesByExtension.end()) {
-            return "application/octet-stream";
+        constexpr char ToLower(char c) {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        // FNV-1a over the lowercased extension, so the lookup is case-insensitive.
+        constexpr uint32_t Hash(std::string_view extension, uint32_t seed) {
+            uint32_t hash = 2166136261u ^ seed;
+            for (char c: extension) {
+                hash = (hash ^ static_cast<uint8_t>(ToLower(c))) * 16777619u;
+            }
+            return hash ^ (hash >> 15);
+        }
+
+        constexpr size_t kEntryCount = sizeof(kEntries) / sizeof(kEntries[0]);
+        constexpr size_t kSlotCount = 1024;
+        static_assert((kSlotCount & (kSlotCount - 1)) == 0 && kEntryCount < 255);
+
+        // A perfect hash: the seed is searched at compile time so that no two extensions share a slot.
+        struct Table {
+            uint32_t seed;
+            // The index of the entry plus one, or zero for an empty slot
+            uint8_t slots[kSlotCount];
+        };
+
+        constexpr Table BuildTable() {
+            for (uint32_t seed = 0; seed < 100000; ++seed) {
+                Table table { seed, { } };
+                bool hasCollision = false;
+                for (size_t i = 0; i < kEntryCount && !hasCollision; ++i) {
+                    uint8_t& slot = table.slots[Hash(kEntries[i].extension, seed) & (kSlotCount - 1)];
+                    hasCollision = (slot != 0);
+                    slot = static_cast<uint8_t>(i + 1);
+                }
+                if (!hasCollision) {
+                    return table;
+                }
+            }
+            throw "No seed makes the hash of the extensions perfect";
+        }
+
+        inline constexpr Table kTable = BuildTable();
+
+        constexpr bool EqualsIgnoringCase(std::string_view extension, std::string_view lowercaseExtension) {
+            if (extension.size() != lowercaseExtension.size()) return false;
+            for (size_t i = 0; i < extension.size(); ++i) {
+                if (ToLower(extension[i]) != lowercaseExtension[i]) return false;
+            }
+            return true;
+        }
+    }
+
+    // The returned view refers to a null-terminated string literal, so its data() can be passed to C APIs.
+    constexpr std::string_view GetMimeTypeOfExtension(std::string_view extension) {
+        uint8_t slot = Mime::kTable.slots[Mime::Hash(extension, Mime::kTable.seed) & (Mime::kSlotCount - 1)];
+        if (slot == 0) {
+            return Mime::kDefaultMimeType;
+        }
+        const Mime::Entry& entry = Mime::kEntries[slot - 1];
+        if (!Mime::EqualsIgnoringCase(extension, entry.extension)) {
+            return Mime::kDefaultMimeType;
         }
-        return findResult->second;
-    };
+        return entry.mimeType;
+    }
 }
 
 #endif
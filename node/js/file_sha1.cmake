@@ -0,0 +1,5 @@
+# Writes a C source defining ${SYMBOL} as the SHA-1 of ${INPUT}, so that it is computed when the file is built
+# instead of at runtime.
+# Usage: cmake -DINPUT=<file> -DOUTPUT=<file.c> -DSYMBOL=<name> -P file_sha1.cmake
+file(SHA1 ${INPUT} HASH)
+file(WRITE ${OUTPUT} "const char ${SYMBOL}[] = \"${HASH}\";\n")
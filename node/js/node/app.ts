@@ -5,10 +5,12 @@ import appPath from './internal/app-path'
 
 import globals from './internal/globals';
 import { EventEmitter, IEventMap } from './internal/events';
-import { bulkUISync } from './internal/dispatch';
+import { bulkUISync, setNonBlockingUIGetters, areUIGettersNonBlocking } from './internal/dispatch';
+import { recordStartupPhase, recordStartupMilestone, getStartupMetrics, getStartupTrace, StartupMetrics } from './internal/startup-trace';
 
 import path = require('path');
-import { AppNative, appNative } from './internal/native';
+import { isMainThread } from 'worker_threads';
+import { AppNative, appNative, UIDispatchStats } from './internal/native';
 
 const pathNameValues = {
     'appData': 0,
@@ -83,6 +85,7 @@ export class App extends EventEmitter<AppEvents> {
     private run_() {
         this.native_.run({
             onReady: () => {
+                recordStartupMilestone('ready');
                 this.isReady_ = true;
                 if (process.platform === 'darwin') {
                     this.actuallySetTheMenu_();
@@ -104,12 +107,36 @@ export class App extends EventEmitter<AppEvents> {
             }
         });
 
-        require(appPath);
+        recordStartupPhase('bundleEval', 'E');
+        recordStartupPhase('appEntry', 'B');
+        try {
+            require(appPath);
+        }
+        finally {
+            recordStartupPhase('appEntry', 'E');
+        }
+    }
+
+    /** @internal */
+    private runInWorker_() {
+        // The main thread only creates a Worker after the app is ready.
+        // 'ready' is emitted after the entry of the worker has been required.
+        this.isReady_ = true;
+        this.resolveWhenReady_();
+        setImmediate(() => {
+            try {
+                this.trigger_('ready');
+            }
+            finally {
+                this.removeAllListeners('ready');
+            }
+        });
     }
 
     /** @internal */
     private notifyWindowAllClosed_() {
-        if (this.triggersWindowAllClosed_) {
+        // Quitting when all the windows are closed is up to the main thread
+        if (this.triggersWindowAllClosed_ && isMainThread) {
             if (!this.trigger_('window-all-closed')) {
                 this.quit();
             }
@@ -264,6 +291,44 @@ export class App extends EventEmitter<AppEvents> {
     getMenu(): Menu | null {
         return this.menu_;
     }
+
+    /**
+     * Opt in to getters that never block the node thread on the UI thread.
+     * `BrowserWindow#getSize` and `BrowserWindow#getPosition` then return the values last reported by the UI thread,
+     * and `resize`/`move` events are emitted after those values are refreshed.
+     */
+    setNonBlockingUIGetters(enabled: boolean): void {
+        setNonBlockingUIGetters(enabled);
+    }
+    areUIGettersNonBlocking(): boolean {
+        return areUIGettersNonBlocking();
+    }
+
+    /**
+     * Counters of the queue that carries actions from the node thread to the UI thread.
+     * Only available on Linux, returns `null` on other platforms.
+     */
+    getUIDispatchStats(): UIDispatchStats | null {
+        if (process.platform !== 'linux') {
+            return null;
+        }
+        return this.native_.getUIDispatchStats();
+    }
+
+    /**
+     * The time spent in each startup phase, from `main()` to the first window being shown.
+     */
+    getStartupMetrics(): StartupMetrics {
+        return getStartupMetrics();
+    }
+
+    /**
+     * The startup phases in the Chrome trace event format. Set the `DESKGAP_STARTUP_TRACE` environment variable
+     * to a file path to have it written there once the first window is shown and loaded, or when the app exits before that.
+     */
+    getStartupTrace(): object {
+        return getStartupTrace();
+    }
 }
 
 const app = new App();
@@ -1,10 +1,11 @@
-import { bulkUISync } from './internal/dispatch';
+import { bulkUISync, areUIGettersNonBlocking } from './internal/dispatch';
+import { recordStartupMilestone } from './internal/startup-trace';
 import { app } from './app';
 import { EventEmitter, IEventMap } from './internal/events';
 import globals from './internal/globals';
 import { Menu, MenuTypeCode } from './menu';
-import { WebView, WebPreferences } from './webview';
-import { BrowserWindowNative } from './internal/native';
+import { WebView, WebPreferences, takePooledWindow } from './webview';
+import { BrowserWindowNative, BrowserWindowNativeCallbacks } from './internal/native';
 
 const TitleBarStyleCode = {
     default: 0,
@@ -78,9 +79,15 @@ export class BrowserWindow extends EventEmitter<BrowserWindowEvents> {
     /** @internal */ private maximumSize_: [number, number];
     /** @internal */ private menu_: Menu | null = null;
     /** @internal */ private menuNativeId_: number | null = null;
+    /** @internal */ private size_: [number, number];
+    // Null while only the UI thread knows the position, as after center()
+    /** @internal */ private position_: [number, number] | null = null;
+    // Bumped by the setters of the position, so an older getPositionAsync does not overwrite the cache
+    /** @internal */ private positionVersion_ = 0;
 
     constructor(options: Partial<IBrowserWindowConstructorOptions> = {}) {
         super();
+        recordStartupMilestone('firstBrowserWindow');
 
         let defaultMenu: Menu | null = null;
         if (process.platform !== 'darwin' && !options.hasOwnProperty('menu')) {
@@ -111,7 +118,7 @@ export class BrowserWindow extends EventEmitter<BrowserWindowEvents> {
         }, options);
 
         bulkUISync(() => {
-            this.webview_ = new WebView({
+            const webViewCallbacks = {
                 onPageTitleUpdated: (title: string) => {
                     if (this.isDestroyed()) return;
                     this.trigger_('page-title-updated', {
@@ -124,9 +131,9 @@ export class BrowserWindow extends EventEmitter<BrowserWindowEvents> {
                         this.trigger_('ready-to-show');
                     }
                 }
-            }, Object.assign({ engine: null }, fullOptions.webPreferences));
-
-            this.native_ = new BrowserWindowNative(this.webview_['native_'], {
+            };
+            const webPreferences: WebPreferences = Object.assign({ engine: null, crossOriginIsolated: false, partition: null }, fullOptions.webPreferences);
+            const windowCallbacks: BrowserWindowNativeCallbacks = {
                 onBlur: () => {
                     if (this.isDestroyed()) return;
                     if (globals.focusedBrowserWindow === this) {
@@ -141,17 +148,40 @@ export class BrowserWindow extends EventEmitter<BrowserWindowEvents> {
                 },
                 onResize: () => {
                     if (this.isDestroyed()) return;
+                    if (process.platform !== 'linux' && areUIGettersNonBlocking()) {
+                        this.getSizeAsync().then(() => {
+                            if (this.isDestroyed()) return;
+                            this.trigger_('resize');
+                        });
+                        return;
+                    }
                     this.trigger_('resize')
                 },
                 onMove: () => {
                     if (this.isDestroyed()) return;
+                    if (process.platform !== 'linux' && areUIGettersNonBlocking()) {
+                        this.getPositionAsync().then(() => {
+                            if (this.isDestroyed()) return;
+                            this.trigger_('move');
+                        });
+                        return;
+                    }
                     this.trigger_('move')
                 },
                 onClose: () => {
                     if (this.isDestroyed()) return;
                     this.trigger_('close', { defaultAction: () => this.destroy() })
                 }
-            });
+            };
+            const pooledWindow = takePooledWindow(webViewCallbacks, windowCallbacks, webPreferences);
+            if (pooledWindow != null) {
+                this.webview_ = pooledWindow.webView;
+                this.native_ = pooledWindow.native;
+            }
+            else {
+                this.webview_ = new WebView(webViewCallbacks, webPreferences);
+                this.native_ = new BrowserWindowNative(this.webview_['native_'], windowCallbacks);
+            }
 
             this.native_.setMaximizable(fullOptions.maximizable);
             this.native_.setMinimizable(fullOptions.minimizable);
@@ -173,10 +203,10 @@ export class BrowserWindow extends EventEmitter<BrowserWindowEvents> {
             this.setMinimumSize(fullOptions.minWidth, fullOptions.minHeight);
             this.setSize(fullOptions.width, fullOptions.height, false);
             if (fullOptions.center) {
-                this.native_.center();
+                this.center();
             }
             else {
-                this.native_.setPosition(fullOptions.x, fullOptions.y, false);
+                this.setPosition(fullOptions.x, fullOptions.y, false);
             }
 
             if (process.platform === 'darwin') {
@@ -216,9 +246,11 @@ export class BrowserWindow extends EventEmitter<BrowserWindowEvents> {
             this.hasBeenShown_ = true;
         }
         this.native_.show();
+        recordStartupMilestone('firstShow');
     }
     setSize(width: number, height: number, animate: boolean = false) {
         this.native_.setSize(width, height, animate);
+        this.size_ = [width, height];
     }
     setMaximumSize(width: number, height: number) {
         this.native_.setMaximumSize(width, height);
@@ -264,6 +296,8 @@ export class BrowserWindow extends EventEmitter<BrowserWindowEvents> {
     }
     setPosition(x: number, y: number, animate: boolean = false): void {
         this.native_.setPosition(x, y, animate);
+        this.position_ = [x, y];
+        ++this.positionVersion_;
     }
     setTitle(title: string): void {
         this.title_ = title;
@@ -272,8 +306,19 @@ export class BrowserWindow extends EventEmitter<BrowserWindowEvents> {
     getTitle(): string {
         return this.title_;
     }
+    /**
+     * Same as [[getTitle]]. The title is kept on the node side, so the promise is resolved without a hop to the UI thread.
+     */
+    getTitleAsync(): Promise<string> {
+        return Promise.resolve(this.title_);
+    }
     center(): void {
         this.native_.center();
+        this.position_ = null;
+        ++this.positionVersion_;
+        if (process.platform !== 'linux' && areUIGettersNonBlocking()) {
+            this.getPositionAsync();
+        }
     }
     setMenu(menu: Menu | null) {
         if (this.menuNativeId_ != null) {
@@ -309,11 +354,54 @@ export class BrowserWindow extends EventEmitter<BrowserWindowEvents> {
         this.native_.setIcon(path);
     }
     getPosition(): [number, number] {
+        // On Linux the native getter reads a snapshot without dispatching to the UI thread
+        if (process.platform !== 'linux' && areUIGettersNonBlocking() && this.position_ != null) {
+            return [this.position_[0], this.position_[1]];
+        }
         return this.native_.getPosition();
     }
     getSize(): [number, number] {
+        if (process.platform !== 'linux' && areUIGettersNonBlocking()) {
+            return [this.size_[0], this.size_[1]];
+        }
         return this.native_.getSize();
     }
+    isFocused(): boolean {
+        if (process.platform === 'linux') {
+            return this.native_.isFocused();
+        }
+        return globals.focusedBrowserWindow === this;
+    }
+    /**
+     * Same as [[isFocused]], but does not block the node thread while the UI thread is busy.
+     */
+    isFocusedAsync(): Promise<boolean> {
+        if (process.platform === 'linux') {
+            return this.native_.isFocusedAsync();
+        }
+        return Promise.resolve(globals.focusedBrowserWindow === this);
+    }
+    /**
+     * Same as [[getPosition]], but does not block the node thread while the UI thread is busy.
+     */
+    getPositionAsync(): Promise<[number, number]> {
+        const positionVersion = this.positionVersion_;
+        return this.native_.getPositionAsync().then((position) => {
+            if (positionVersion === this.positionVersion_) {
+                this.position_ = position;
+            }
+            return position;
+        });
+    }
+    /**
+     * Same as [[getSize]], but does not block the node thread while the UI thread is busy.
+     */
+    getSizeAsync(): Promise<[number, number]> {
+        return this.native_.getSizeAsync().then((size) => {
+            this.size_ = size;
+            return size;
+        });
+    }
 
     destroy(): void {
         bulkUISync(() => {
@@ -321,10 +409,9 @@ export class BrowserWindow extends EventEmitter<BrowserWindowEvents> {
                 this.menu_!['destroyNative_'](this.menuNativeId_);
                 this.menu_ = null;
             }
-            this.webview_['native_'].destroy();
+            this.webview_['destroy_']();
             this.native_.destroy();
         });
-        this.webview_['native_'] = null;
         this.native_ = null;
 
         if (globals.focusedBrowserWindow === this) {
@@ -8,7 +8,9 @@ import { Dialog } from './dialog';
 import { Tray } from './tray'
 import { shell } from './shell';
 import { systemPreferences } from './system-preferences';
+import { Worker } from './worker';
 import { registerModule } from './internal/cjs-intercept';
+import { isMainThread } from 'worker_threads';
 
 const deskgap = {
     app,
@@ -22,20 +24,26 @@ const deskgap = {
     Tray,
     NativeException,
     shell,
+    Worker,
 };
 
 // export = deskgap;
 registerModule(deskgap);
 
-process.on('uncaughtException', (error) => {
-    if (process.listeners('uncaughtException').length > 1) {
-        return;
-    }
-    const message = error.stack || `${error.name}: ${error.message}`;
-    console.error('Uncaught exception', message);
-    Dialog.showErrorBox('Uncaught exception', message);
-    process.exit(1);
-});
-
-app['run_']();
+if (isMainThread) {
+    process.on('uncaughtException', (error) => {
+        if (process.listeners('uncaughtException').length > 1) {
+            return;
+        }
+        const message = error.stack || `${error.name}: ${error.message}`;
+        console.error('Uncaught exception', message);
+        Dialog.showErrorBox('Uncaught exception', message);
+        process.exit(1);
+    });
 
+    app['run_']();
+}
+else {
+    // Uncaught exceptions of a worker are emitted as 'error' on its Worker object
+    app['runInWorker_']();
+}
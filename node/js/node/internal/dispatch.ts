@@ -1,19 +1,27 @@
 const { delayUISync, commitUISync } = require('./bindings');
 
-let inBulkUISync = false;
-export const bulkUISync = (block: () => void) => {
-    // return block();
-    if (inBulkUISync) {
-        return block();
-    }
-
-    inBulkUISync = true;
+/**
+ * Runs the block in a UI transaction: the native calls that change the UI are queued and applied together after it.
+ * Transactions can be nested, and only the outermost one commits. A large commit is applied in slices,
+ * so the UI stays responsive while it is applied.
+ */
+export const bulkUISync = <T>(block: () => T): T => {
     delayUISync();
     try {
         return block();
     }
     finally {
-        inBulkUISync = false;
         commitUISync();
     }
 }
+
+
+let nonBlockingUIGetters = false;
+/**
+ * When enabled, getters like BrowserWindow#getSize return values cached on the node thread,
+ * which are refreshed by the promise-returning native getters instead of blocking on the UI thread.
+ */
+export const setNonBlockingUIGetters = (enabled: boolean) => {
+    nonBlockingUIGetters = enabled;
+}
+export const areUIGettersNonBlocking = () => nonBlockingUIGetters;
@@ -0,0 +1,78 @@
+/**
+ * Pairs the new entries of a list with the old ones they can be updated from, keeping the order of both.
+ * Returns the index of the paired old entry for each new entry, or -1 if it has to be inserted.
+ * The unpaired old entries are to be removed.
+ *
+ * The entries with the same key are paired first, keeping the longest run whose order is unchanged,
+ * so moving one entry only removes and inserts that entry. Then the entries left between two pairs
+ * are paired by position if `canReuse` allows it, so changing a label updates the entry in place.
+ */
+export function matchEntries<Old, New>(
+    oldEntries: Old[], newEntries: New[],
+    keyOfOld: (entry: Old) => string, keyOfNew: (entry: New) => string,
+    canReuse: (oldEntry: Old, newEntry: New) => boolean
+): number[] {
+    const matches = new Array<number>(newEntries.length).fill(-1);
+
+    const oldIndicesByKey = new Map<string, number[]>();
+    for (let i = oldEntries.length - 1; i >= 0; --i) {
+        const key = keyOfOld(oldEntries[i]);
+        const indices = oldIndicesByKey.get(key);
+        if (indices == null) {
+            oldIndicesByKey.set(key, [i]);
+        }
+        else {
+            indices.push(i);
+        }
+    }
+    const candidates = newEntries.map((entry) => {
+        const indices = oldIndicesByKey.get(keyOfNew(entry));
+        if (indices == null || indices.length === 0) return -1;
+        const oldIndex = indices.pop()!;
+        return canReuse(oldEntries[oldIndex], entry) ? oldIndex : -1;
+    });
+
+    // The longest increasing subsequence of the candidates
+    const tailNewIndices: number[] = [];
+    const previousNewIndices = new Array<number>(newEntries.length).fill(-1);
+    candidates.forEach((oldIndex, newIndex) => {
+        if (oldIndex === -1) return;
+        let low = 0, high = tailNewIndices.length;
+        while (low < high) {
+            const middle = (low + high) >> 1;
+            if (candidates[tailNewIndices[middle]] < oldIndex) {
+                low = middle + 1;
+            }
+            else {
+                high = middle;
+            }
+        }
+        previousNewIndices[newIndex] = low > 0 ? tailNewIndices[low - 1] : -1;
+        tailNewIndices[low] = newIndex;
+    });
+    for (let newIndex = tailNewIndices.length > 0 ? tailNewIndices[tailNewIndices.length - 1] : -1; newIndex !== -1; newIndex = previousNewIndices[newIndex]) {
+        matches[newIndex] = candidates[newIndex];
+    }
+
+    const isOldMatched = new Array<boolean>(oldEntries.length).fill(false);
+    for (const oldIndex of matches) {
+        if (oldIndex !== -1) isOldMatched[oldIndex] = true;
+    }
+    let oldCursor = 0;
+    matches.forEach((oldIndex, newIndex) => {
+        if (oldIndex !== -1) {
+            oldCursor = oldIndex + 1;
+            return;
+        }
+        for (; oldCursor < oldEntries.length && !isOldMatched[oldCursor]; ++oldCursor) {
+            if (canReuse(oldEntries[oldCursor], newEntries[newIndex])) {
+                matches[newIndex] = oldCursor;
+                isOldMatched[oldCursor] = true;
+                ++oldCursor;
+                break;
+            }
+        }
+    });
+
+    return matches;
+}
@@ -24,21 +24,52 @@ export interface AppNative {
     getResourcePath(): string
     setMenu(menu: MenuNative | null): string
     getArgv(): string[]
+    /** Linux only */
+    getUIDispatchStats(): UIDispatchStats
+    recordStartupPhase(name: string, phase: 'B' | 'E' | 'I'): void
+    getStartupTraceEvents(): StartupTraceEvent[]
 }
 
-//@ts-expect-error
-export declare class MenuItemNative {
-    setEnabled(enabled: boolean): void;
-    setLabel(label: string): void;
-    setChecked(checked: boolean): void;
-    setAccelerator(acceleratorTokens: string[]): void;
-    destroy(): void;
-    constructor(role: string, typeCode: number, submenu: MenuNative | null, onClick: () => void);
+export interface StartupTraceEvent {
+    name: string
+    ph: 'B' | 'E' | 'I'
+    /** 1 for the UI thread, 2 for the node thread */
+    tid: number
+    /** Microseconds since main() */
+    ts: number
+}
+
+export interface UIDispatchStats {
+    queueDepth: number
+    maxQueueDepth: number
+    dispatchedActions: number
+    /** How many main loop iterations drained the queue */
+    wakeups: number
+    totalLatencyMicroseconds: number
+    maxLatencyMicroseconds: number
 }
 
 //@ts-expect-error
 export declare class MenuNative {
-    append(item: MenuItemNative): void;
+    /**
+     * @param serializedItems [id, type, role, label, enabled, checked, accelerator tokens joined by spaces, child count (-1 without a submenu),
+     * whether the showing and hiding of the submenu are reported] for each item, followed by its children
+     * @param callbacks Called with the id of the item that is clicked, or whose submenu is shown or hidden
+     */
+    appendTemplate(serializedItems: Array<number | string | boolean>, callbacks: {
+        onClick: (itemId: number) => void,
+        onSubmenuShow: (itemId: number) => void,
+        onSubmenuHide: (itemId: number) => void
+    }): void;
+    /**
+     * @param patches One operation after another:
+     * [0 (remove), id count, ids of the item and its descendants in pre-order...],
+     * [1 (insert), parent id (-1 for this menu), index, item count, serialized items as in appendTemplate...],
+     * [2 (label) | 3 (enabled) | 4 (checked) | 5 (accelerator tokens joined by spaces), id, value]
+     */
+    patchTemplate(patches: Array<number | string | boolean>): void;
+    setTemplateItemEnabled(itemId: number, enabled: boolean): void;
+    setTemplateItemChecked(itemId: number, checked: boolean): void;
     destroy(): void;
     constructor(typeCode: number, callbacks: {});
 }
@@ -58,6 +89,43 @@ export declare class TrayNative {
     })
 }
 
+export interface MessageQueueStats {
+    pendingMessages: number;
+    pendingBytes: number;
+    inFlightMessages: number;
+    inFlightBytes: number;
+    deliveredMessages: number;
+    deliveredBatches: number;
+    maxBufferedBytes: number;
+    highWaterMark: number;
+}
+
+/** Durations are in milliseconds */
+export interface NativeIpcStats {
+    messagesToPage: number;
+    bytesToPage: number;
+    /** Linux only */
+    binaryMessagesToPage: number;
+    /** Linux only */
+    binaryBytesToPage: number;
+    batchesToPage: number;
+    /** The messages to the page that are queued or being delivered */
+    queueDepth: number;
+    /** The sum over the messages to the page of the time from being queued to the page having run them */
+    totalDeliveryLatency: number;
+    maxDeliveryLatency: number;
+    /** Joining the queued messages into scripts */
+    totalBatchBuildTime: number;
+    messagesFromPage: number;
+    /** UTF-16 bytes on Linux, UTF-8 bytes elsewhere */
+    bytesFromPage: number;
+    binaryMessagesFromPage: number;
+    binaryBytesFromPage: number;
+    /** The sum over the messages from the page of the time from the UI thread receiving them to the node thread converting them */
+    totalReceiveLatency: number;
+    maxReceiveLatency: number;
+}
+
 /**
  * node\src\node_bindings\webview\webview_wrap.cc
  */
@@ -68,34 +136,51 @@ export declare class WebViewNative {
             didFinishLoad: () => void,
             onStringMessage: (stringMessage: string) => void,
             onPageTitleUpdated: (title: string) => void,
+            onBinaryMessage: (binaryMessage: Buffer) => void,
+            onMessageQueueDrain: () => void,
         },
         engine: number | null,
+        /** Linux only */
+        partition: string | null,
     )
 
     loadLocalFile(path: string): void
     loadRequest(method: string, url: string, headers: Array<[string, string]>, body?: string): void
     setDevToolsEnabled(enabled: boolean): void
     executeJavaScript(script: string, callback: ((error: string) => void) | null): void
+    /** Returns false once the queued and in-flight messages reach the high-water mark */
+    queueMessage(json: string): boolean
+    flushMessages(): void
+    setMessageQueueHighWaterMark(bytes: number): void
+    getMessageQueueStats(): MessageQueueStats
+    getIpcStats(): NativeIpcStats
+    /** Linux only */
+    postBinaryMessage(data: ArrayBufferView): void
+    /** Linux only */
+    setCrossOriginIsolated(isolated: boolean): void
     reload(): void
     destroy(): void
 
     static isWinRTEngineAvailable(): boolean
     static getWebview2Version(): string
+    /** Linux only */
+    static setContextOptions(cacheModel: number, webProcessCountLimit: number): void
 }
 
 /**
  * node\src\node_bindings\window\browser_window_wrap.cc
  */
+export interface BrowserWindowNativeCallbacks {
+    onBlur(): void
+    onFocus(): void
+    onResize(): void
+    onMove(): void
+    onClose(): void
+}
+
 //@ts-expect-error
 export declare class BrowserWindowNative {
-    constructor(webview: WebViewNative,
-        callbacks: {
-            onBlur(): void
-            onFocus(): void
-            onResize(): void
-            onMove(): void
-            onClose(): void
-        })
+    constructor(webview: WebViewNative, callbacks: BrowserWindowNativeCallbacks)
     setMaximizable(value: boolean): void
     setMinimizable(value: boolean): void
     setResizable(value: boolean): void
@@ -105,11 +190,17 @@ export declare class BrowserWindowNative {
     center(): void
     setPosition(x: number, y: number, animate: boolean): void
     getPosition(): [number, number]
+    getPositionAsync(): Promise<[number, number]>
 
     setSize(w: number, h: number, animate: boolean): void
     setMaximumSize(w: number, h: number): void
     setMinimumSize(w: number, h: number): void
     getSize(): [number, number]
+    getSizeAsync(): Promise<[number, number]>
+    /** Linux only */
+    isFocused(): boolean
+    /** Linux only */
+    isFocusedAsync(): Promise<boolean>
     minimize(): void
 
     setTitle(title: string): void
@@ -166,8 +257,6 @@ export interface SystemPreferencesNative {
     getAndWatchDarkMode(watcher: () => void): boolean
 }
 
-//@ts-expect-error
-export const MenuItemNative = bindings.MenuItemNative
 //@ts-expect-error
 export const MenuNative = bindings.MenuNative
 //@ts-expect-error
@@ -0,0 +1,115 @@
+import fs = require('fs');
+import { isMainThread } from 'worker_threads';
+import { appNative, StartupTraceEvent } from './native';
+
+export type StartupTracePhase = 'B' | 'E' | 'I';
+
+const threadNames: Record<number, 'ui' | 'node'> = {
+    1: 'ui',
+    2: 'node',
+};
+
+export interface StartupPhase {
+    name: string;
+    thread: 'ui' | 'node';
+    /** Milliseconds since the process entered `main()` */
+    start: number;
+    /** Milliseconds, zero for the phases that are a single point in time */
+    duration: number;
+}
+
+export interface StartupMetrics {
+    phases: StartupPhase[];
+}
+
+export const recordStartupPhase = (name: string, phase: StartupTracePhase) => {
+    appNative.recordStartupPhase(name, phase);
+};
+
+const traceFilePath = process.env['DESKGAP_STARTUP_TRACE'];
+// The startup is over once all of them are recorded
+const finalMilestones = ['firstDidFinishLoad', 'firstShow'];
+let isTraceWritten = false;
+
+const writeStartupTrace = () => {
+    if (!traceFilePath || isTraceWritten) return;
+    isTraceWritten = true;
+    try {
+        fs.writeFileSync(traceFilePath, JSON.stringify(getStartupTrace()));
+    }
+    catch (e) {
+        // A diagnostic option never breaks the app
+        process.emitWarning(`Failed to write the startup trace to ${traceFilePath}: ${e instanceof Error ? e.message : e}`);
+    }
+};
+
+if (traceFilePath && isMainThread) {
+    // For the apps that exit before the startup is over
+    process.once('exit', writeStartupTrace);
+}
+
+const recordedMilestones = new Set<string>();
+/**
+ * Records a point in time that only matters the first time it happens, like the first window being shown.
+ * If `DESKGAP_STARTUP_TRACE` is set to a file path, the trace is written there once, after the last milestone of the startup
+ * or when the process exits before it.
+ */
+export const recordStartupMilestone = (name: string) => {
+    // The native side does not record the phases of a worker either
+    if (!isMainThread || recordedMilestones.has(name)) return;
+    recordedMilestones.add(name);
+    appNative.recordStartupPhase(name, 'I');
+
+    if (finalMilestones.every(milestone => recordedMilestones.has(milestone))) {
+        writeStartupTrace();
+    }
+};
+
+export const getStartupMetrics = (): StartupMetrics => {
+    const phases: StartupPhase[] = [];
+    const openPhases = new Map<string, StartupTraceEvent>();
+    for (const event of appNative.getStartupTraceEvents()) {
+        if (event.ph === 'B') {
+            openPhases.set(event.name, event);
+            continue;
+        }
+        let begin = event;
+        if (event.ph === 'E') {
+            const openPhase = openPhases.get(event.name);
+            if (openPhase == null) continue;
+            openPhases.delete(event.name);
+            begin = openPhase;
+        }
+        phases.push({
+            name: event.name,
+            thread: threadNames[begin.tid],
+            start: begin.ts / 1000,
+            duration: (event.ts - begin.ts) / 1000,
+        });
+    }
+    return { phases: phases.sort((a, b) => a.start - b.start) };
+};
+
+/**
+ * The recorded phases in the Chrome trace event format, which can be loaded by chrome://tracing or Perfetto.
+ */
+export const getStartupTrace = () => {
+    const events = appNative.getStartupTraceEvents();
+    return {
+        traceEvents: [
+            ...Object.entries(threadNames).map(([tid, name]) => ({
+                name: 'thread_name', ph: 'M', pid: process.pid, tid: Number(tid), args: { name }
+            })),
+            ...events.map((event) => ({
+                name: event.name,
+                cat: 'startup',
+                ph: event.ph,
+                ts: event.ts,
+                pid: process.pid,
+                tid: event.tid,
+                ...(event.ph === 'I' ? { s: 'p' } : {}),
+            })),
+        ],
+        displayTimeUnit: 'ms',
+    };
+};
@@ -3,7 +3,8 @@ import { parseAcceleratorToTokens } from './accelerator';
 import globals from './internal/globals';
 import { BrowserWindow } from './browser-window'
 import roleDefaults, { Role } from './internal/menu/roles';
-import { MenuItemNative, MenuNative } from './internal/native';
+import { MenuNative } from './internal/native';
+import { matchEntries } from './internal/menu/match';
 
 export type MenuItemType = 'normal' | 'separator' | 'submenu' | 'checkbox';
 
@@ -19,15 +20,87 @@ export const MenuTypeCode = {
     main: 0, context: 1, submenu: 2
 };
 
+/** @internal */
+const TemplatePatchCode = {
+    remove: 0, insert: 1, setLabel: 2, setEnabled: 3, setChecked: 4, setAccelerator: 5
+};
+
+/** @internal A native menu built from a template by Menu#createNative_ */
+interface NativeTemplate {
+    native: MenuNative;
+    /** The items of the native menu by their ids. The ids of the removed items are not reused. */
+    itemsById: Array<MenuItem | undefined>;
+}
+
+/** @internal The patches for Menu#update, by the ids of the native menus */
+type TemplatePatches = Map<number, [NativeTemplate, Array<number | string | boolean>]>;
+
+/** @internal */
+function patchesOf(patches: TemplatePatches, nativeId: number, template: NativeTemplate): Array<number | string | boolean> {
+    let nativePatches = patches.get(nativeId);
+    if (nativePatches == null) {
+        nativePatches = [template, []];
+        patches.set(nativeId, nativePatches);
+    }
+    return nativePatches[1];
+}
+
+/** @internal */
+function sendPatches(patches: TemplatePatches): void {
+    for (const [{ native }, nativePatches] of patches.values()) {
+        if (nativePatches.length > 0) {
+            native.patchTemplate(nativePatches);
+        }
+    }
+}
+
+export type MenuTemplate = Array<Partial<MenuItemConstructorOptions> | null>;
+
+/**
+ * Fills a lazy submenu when it is about to be shown. It returns the items, a promise of them,
+ * or an async iterable of pages of them, which are appended one after another while the submenu is open.
+ */
+export type LazySubmenuProvider = () => MenuTemplate | Promise<MenuTemplate> | AsyncIterable<MenuTemplate>;
+
+/** @internal */
+interface LazySubmenu {
+    provider: LazySubmenuProvider;
+    retains: boolean;
+    /** Shown until the first items are loaded */
+    placeholder: MenuItem;
+    /** How many native menus are showing the submenu */
+    shownCount: number;
+    isLoaded: boolean;
+    /**
+     * Closed without retaining its items. They are dropped when it is shown again instead of when it is closed,
+     * because the click on one of them arrives after the submenu is closed on every platform.
+     */
+    isStale: boolean;
+    /** Bumped when the items are dropped, which stops the loading of the pages */
+    generation: number;
+}
+
+/** @internal */
+const kLazySubmenuLoadingLabel = 'Loading…';
+/** @internal */
+const kLazySubmenuEmptyLabel = 'Empty';
+/** @internal */
+const kLazySubmenuFailedLabel = 'Failed to Load';
+
 export interface MenuItemConstructorOptions {
     role: Role;
-    submenu: Array<Partial<MenuItemConstructorOptions> | null> | Menu;
+    /** A function makes a lazy submenu, which is filled only when it is shown */
+    submenu: MenuTemplate | Menu | LazySubmenuProvider;
     type: MenuItemType;
     label: string;
     enabled: boolean;
     checked: boolean;
     click: (item: MenuItem, window: BrowserWindow) => void;
     accelerator: string;
+    /** Tells Menu#update which item is which when the items are moved or relabeled */
+    id: string;
+    /** Whether a lazy submenu keeps its items after it is closed, instead of loading them again the next time */
+    retainSubmenu: boolean;
 }
 
 export interface IMenuPopupOptions {
@@ -40,6 +113,8 @@ export const MenuNativeKey = Symbol('MenuNative')
 
 export class Menu {
     /** @internal */ private natives_ = new Map<number, MenuNative>();
+    /** @internal The native menus showing this menu, with the id of the item it is the submenu of (-1 for the root) */
+    private templateNatives_ = new Map<number, [NativeTemplate, number]>();
     public items: MenuItem[] = [];
 
     /** @internal */ private nativeCallbacks_ = {};
@@ -97,62 +172,209 @@ export class Menu {
     }
 
     /** @internal */
-    public createNative_(type: number, window: BrowserWindow | null, theNativeId?: number): [number, MenuNative] {
-        const nativeId = theNativeId || ++lastNativeId;
-        //console.log(nativeId);
+    public createNative_(type: number, window: BrowserWindow | null): [number, MenuNative] {
+        const nativeId = ++lastNativeId;
 
         const native = new MenuNative(type, this.nativeCallbacks_);
         this.natives_.set(nativeId, native);
 
+        // The whole tree is built natively in one call, and the clicks of its items come back by their ids
+        const template: NativeTemplate = { native, itemsById: [] };
+        const serializedItems: Array<number | string | boolean> = [];
+        this.templateNatives_.set(nativeId, [template, -1]);
         for (const item of this.items) {
-            const nativeMenuItem = item['createNative_'](nativeId, window);
-            native.append(nativeMenuItem);
+            item['serialize_'](serializedItems, nativeId, template);
         }
+        native.appendTemplate(serializedItems, {
+            onClick: (itemId) => {
+                const item = template.itemsById[itemId];
+                if (item != null) item['handleClick_'](window);
+            },
+            onSubmenuShow: (itemId) => {
+                const item = template.itemsById[itemId];
+                if (item != null) item['handleSubmenuShow_']();
+            },
+            onSubmenuHide: (itemId) => {
+                const item = template.itemsById[itemId];
+                if (item != null) item['handleSubmenuHide_']();
+            }
+        });
 
         return [nativeId, native];
     }
     /** @internal */
     public destroyNative_(nativeId: number): void {
-        for (const item of this.items) {
-            item['destroyNative_'](nativeId);
-        }
+        this.forgetNative_(nativeId);
         const native = this.natives_.get(nativeId)!;
         native.destroy();
         this.natives_.delete(nativeId);
     }
+    /** @internal */
+    private forgetNative_(nativeId: number): void {
+        this.templateNatives_.delete(nativeId);
+        for (const item of this.items) {
+            item['forgetNative_'](nativeId, []);
+        }
+    }
+
+    /**
+     * Changes the items to match the template, in place. The items that can be kept are updated,
+     * and only the changed items of the menus already shown are touched.
+     * An item is kept if it has the same id, type, role and kind of submenu. Without ids, the items
+     * are told apart by their labels.
+     */
+    update(template: MenuTemplate): void {
+        const patches: TemplatePatches = new Map();
+        this.patchItems_(template, patches);
+        sendPatches(patches);
+    }
+    /** @internal */
+    private patchItems_(template: MenuTemplate, patches: TemplatePatches): void {
+        const oldItems = this.items;
+        const newOptions: MenuItemConstructorOptions[] = [];
+        for (const options of template) {
+            if (options != null) {
+                newOptions.push(fillMenuItemOptions(options));
+            }
+        }
+        const matches = matchEntries(
+            oldItems, newOptions,
+            (item) => menuItemKeyOf(item['id_'], item['type_'], item['role_'], item['label_']),
+            (options) => menuItemKeyOf(options.id, MenuItemTypeCode[options.type], options.role, options.label),
+            (item, options) => item['canUpdateTo_'](options)
+        );
+
+        // The removals go first, so the indices of the insertions are those in the new items
+        const isKept = new Array<boolean>(oldItems.length).fill(false);
+        for (const oldIndex of matches) {
+            if (oldIndex !== -1) isKept[oldIndex] = true;
+        }
+        oldItems.forEach((item, oldIndex) => {
+            if (!isKept[oldIndex]) {
+                item['removeFromNatives_'](patches);
+            }
+        });
+
+        this.items = newOptions.map((options, index) => {
+            const oldIndex = matches[index];
+            if (oldIndex !== -1) {
+                const item = oldItems[oldIndex];
+                item['patch_'](options, patches);
+                return item;
+            }
+            const item = new MenuItem(options);
+            this.insertIntoNatives_(item, index, patches);
+            return item;
+        });
+    }
+    /** @internal */
+    private insertIntoNatives_(item: MenuItem, index: number, patches: TemplatePatches): void {
+        for (const [nativeId, [nativeTemplate, parentId]] of this.templateNatives_) {
+            const serializedItems: Array<number | string | boolean> = [];
+            item['serialize_'](serializedItems, nativeId, nativeTemplate);
+            const nativePatches = patchesOf(patches, nativeId, nativeTemplate);
+            nativePatches.push(TemplatePatchCode.insert, parentId, index, serializedItems.length / kSerializedItemFieldCount);
+            // Not push(...serializedItems), which can take too many arguments
+            for (const field of serializedItems) {
+                nativePatches.push(field);
+            }
+        }
+    }
+    /** @internal Appends a page of a lazy submenu. The placeholder is removed by the first page that is not empty. */
+    private appendLazyItems_(template: MenuTemplate, placeholder: MenuItem): void {
+        const patches: TemplatePatches = new Map();
+        for (const options of template) {
+            if (options == null) continue;
+            if (this.items.length === 1 && this.items[0] === placeholder) {
+                placeholder['removeFromNatives_'](patches);
+                this.items.pop();
+            }
+            const item = new MenuItem(options);
+            this.insertIntoNatives_(item, this.items.length, patches);
+            this.items.push(item);
+        }
+        sendPatches(patches);
+    }
+    /** @internal Drops the items of a lazy submenu and puts back its placeholder */
+    private resetLazyItems_(placeholder: MenuItem): void {
+        const patches: TemplatePatches = new Map();
+        for (const item of this.items) {
+            if (item !== placeholder) {
+                item['removeFromNatives_'](patches);
+            }
+        }
+        if (!this.items.includes(placeholder)) {
+            this.insertIntoNatives_(placeholder, 0, patches);
+        }
+        this.items = [placeholder];
+        placeholder['setLabel_'](kLazySubmenuLoadingLabel, patches);
+        sendPatches(patches);
+    }
 
 };
 
+/** @internal The fields of an item serialized for MenuNative#appendTemplate */
+const kSerializedItemFieldCount = 9;
+
+/** @internal Fills the options of a MenuItem with the defaults of its role and the defaults of all items */
+function fillMenuItemOptions(options: Partial<MenuItemConstructorOptions>): MenuItemConstructorOptions {
+    if (options.role != null) {
+        const lowerCasedRole = options.role.toLowerCase() as Role;
+        options = Object.assign({}, roleDefaults[lowerCasedRole], options);
+        options.role = lowerCasedRole;
+    }
+
+    return Object.assign({
+        label: '',
+        type: (options.submenu != null) ? 'submenu' : 'normal',
+        checked: false,
+        submenu: null,
+        click: null,
+        enabled: true,
+        accelerator: '',
+        role: '',
+        id: '',
+        retainSubmenu: false
+    }, options);
+}
+
+/** @internal What Menu#update pairs the old and new items by */
+function menuItemKeyOf(id: string, typeCode: number, role: string, label: string): string {
+    return id !== '' ? `#${id}` : `${typeCode}:${role}:${label}`;
+}
+
 export class MenuItem {
+    /** @internal */ private id_: string;
     /** @internal */ private label_: string;
     /** @internal */ private enabled_: boolean;
     /** @internal */ private type_: number;
     public click: (item: MenuItem, window: BrowserWindow | null) => void;
     /** @internal */ private submenu_: Menu | null;
-    /** @internal */ private natives_ = new Map<number, MenuItemNative>();
+    /** @internal The native menus showing this item, with the id of the item in each */
+    private templateNatives_ = new Map<number, [NativeTemplate, number]>();
     /** @internal */ private checked_: boolean;
     /** @internal */ private accelerator_: string;
     /** @internal */ private role_: string;
+    /** @internal */ private lazySubmenu_: LazySubmenu | null = null;
 
     constructor(options: Partial<MenuItemConstructorOptions> = {}) {
-        if (options.role != null) {
-            const lowerCasedRole = options.role.toLowerCase() as Role;
-            options = Object.assign({}, roleDefaults[lowerCasedRole], options);
-            options.role = lowerCasedRole;
-        }
-
-        const fullOptions: MenuItemConstructorOptions = Object.assign({
-            label: '',
-            type: (options.submenu != null) ? 'submenu' : 'normal',
-            checked: false,
-            submenu: null,
-            click: null,
-            enabled: true,
-            accelerator: '',
-            role: ''
-        }, options);
-
-        if (fullOptions.submenu != null && !(fullOptions.submenu instanceof Menu)) {
+        const fullOptions = fillMenuItemOptions(options);
+
+        if (typeof fullOptions.submenu === 'function') {
+            const placeholder = new MenuItem({ label: kLazySubmenuLoadingLabel, enabled: false });
+            this.lazySubmenu_ = {
+                provider: fullOptions.submenu,
+                retains: fullOptions.retainSubmenu,
+                placeholder,
+                shownCount: 0,
+                isLoaded: false,
+                isStale: false,
+                generation: 0
+            };
+            fullOptions.submenu = new Menu();
+            fullOptions.submenu.append(placeholder);
+        }
+        else if (fullOptions.submenu != null && !(fullOptions.submenu instanceof Menu)) {
             fullOptions.submenu = Menu.buildFromTemplate(fullOptions.submenu);
         }
 
@@ -160,6 +382,7 @@ export class MenuItem {
             fullOptions.submenu = new Menu();
         }
 
+        this.id_ = fullOptions.id;
         this.label_ = fullOptions.label;
         this.enabled_ = fullOptions.enabled;
         this.submenu_ = fullOptions.submenu as (Menu | null);
@@ -170,6 +393,9 @@ export class MenuItem {
         this.role_ = fullOptions.role;
     }
 
+    get id(): string {
+        return this.id_;
+    }
     get label(): string {
         return this.label_;
     }
@@ -181,9 +407,9 @@ export class MenuItem {
     }
     set enabled(value: boolean) {
         bulkUISync(() => {
-            for (const native of this.natives_.values()) {
-                native.setEnabled(value);
-            };
+            for (const [{ native }, itemId] of this.templateNatives_.values()) {
+                native.setTemplateItemEnabled(itemId, value);
+            }
         });
         this.enabled_ = value;
     }
@@ -192,8 +418,8 @@ export class MenuItem {
     }
     set checked(value: boolean) {
         bulkUISync(() => {
-            for (const native of this.natives_.values()) {
-                native.setChecked(value);
+            for (const [{ native }, itemId] of this.templateNatives_.values()) {
+                native.setTemplateItemChecked(itemId, value);
             }
         });
         this.checked_ = value
@@ -202,42 +428,197 @@ export class MenuItem {
         return this.accelerator_;
     }
 
-    /** @internal */
-    private createNative_(nativeId: number, window: BrowserWindow | null): MenuItemNative {
-
-        let nativeSubmenu: MenuNative | null = null;
-        if (this.submenu_ != null) {
-            [, nativeSubmenu] = this.submenu_['createNative_'](MenuItemTypeCode.submenu, window, nativeId);
+    /** @internal Appends the item and its descendants for MenuNative#appendTemplate, and gives them ids in the native menu */
+    private serialize_(serializedItems: Array<number | string | boolean>, nativeId: number, template: NativeTemplate): void {
+        const itemId = template.itemsById.length;
+        template.itemsById.push(this);
+        this.templateNatives_.set(nativeId, [template, itemId]);
+
+        const submenu = this.submenu_;
+        serializedItems.push(
+            itemId, this.type_, this.role_, this.label_, this.enabled_, this.checked_,
+            parseAcceleratorToTokens(this.accelerator_).join(' '),
+            submenu == null ? -1 : submenu.items.length,
+            this.lazySubmenu_ != null
+        );
+        if (submenu != null) {
+            submenu['templateNatives_'].set(nativeId, [template, itemId]);
+            for (const item of submenu.items) {
+                item.serialize_(serializedItems, nativeId, template);
+            }
         }
-
-        const native = new MenuItemNative(this.role_, this.type_, nativeSubmenu, () => {
-            if (this.type_ === MenuItemTypeCode.checkbox) {
-                this.checked = !this.checked;
+    }
+    /** @internal Removes the item and its descendants from all the native menus */
+    private removeFromNatives_(patches: TemplatePatches): void {
+        for (const [nativeId, [nativeTemplate]] of this.templateNatives_) {
+            const removedIds: number[] = [];
+            this.forgetNative_(nativeId, removedIds);
+            for (const removedId of removedIds) {
+                nativeTemplate.itemsById[removedId] = undefined;
             }
-            if (this.click != null) {
-                this.click(this, window || globals.focusedBrowserWindow);
+            const nativePatches = patchesOf(patches, nativeId, nativeTemplate);
+            nativePatches.push(TemplatePatchCode.remove, removedIds.length);
+            for (const removedId of removedIds) {
+                nativePatches.push(removedId);
             }
-        });
-
-        native.setEnabled(this.enabled_);
-        native.setLabel(this.label_);
-        native.setChecked(this.checked_);
-
-        const acceleratorTokens = parseAcceleratorToTokens(this.accelerator_);
-        native.setAccelerator(acceleratorTokens);
+        }
+    }
+    /** @internal Appends the ids of the item and its descendants in the native menu, in pre-order */
+    private forgetNative_(nativeId: number, forgottenIds: number[]): void {
+        const entry = this.templateNatives_.get(nativeId);
+        if (entry != null) {
+            forgottenIds.push(entry[1]);
+            this.templateNatives_.delete(nativeId);
+        }
+        if (this.submenu_ != null) {
+            this.submenu_['templateNatives_'].delete(nativeId);
+            for (const item of this.submenu_.items) {
+                item.forgetNative_(nativeId, forgottenIds);
+            }
+        }
+    }
 
-        this.natives_.set(nativeId, native);
+    /** @internal Whether the item can be updated in place to the options, which are filled by fillMenuItemOptions */
+    private canUpdateTo_(options: MenuItemConstructorOptions): boolean {
+        if (options.id !== this.id_ || options.role !== this.role_ || MenuItemTypeCode[options.type] !== this.type_) {
+            return false;
+        }
+        const hasSubmenu = options.submenu != null || options.type === 'submenu';
+        if (hasSubmenu !== (this.submenu_ != null)) {
+            return false;
+        }
+        if (typeof options.submenu === 'function' || this.lazySubmenu_ != null) {
+            return typeof options.submenu === 'function' && this.lazySubmenu_ != null;
+        }
+        // Another Menu object is another menu. The same one is left as it is.
+        return !(options.submenu instanceof Menu) || options.submenu === this.submenu_;
+    }
+    /** @internal Updates the item to the options, which canUpdateTo_ has accepted */
+    private patch_(options: MenuItemConstructorOptions, patches: TemplatePatches): void {
+        this.setLabel_(options.label, patches);
+        if (options.enabled !== this.enabled_) {
+            this.enabled_ = options.enabled;
+            this.pushPatch_(patches, TemplatePatchCode.setEnabled, options.enabled);
+        }
+        if (options.checked !== this.checked_) {
+            this.checked_ = options.checked;
+            this.pushPatch_(patches, TemplatePatchCode.setChecked, options.checked);
+        }
+        if (options.accelerator !== this.accelerator_) {
+            this.accelerator_ = options.accelerator;
+            this.pushPatch_(patches, TemplatePatchCode.setAccelerator, parseAcceleratorToTokens(options.accelerator).join(' '));
+        }
+        this.click = options.click;
+
+        const lazySubmenu = this.lazySubmenu_;
+        if (lazySubmenu != null && typeof options.submenu === 'function') {
+            lazySubmenu.retains = options.retainSubmenu;
+            if (lazySubmenu.provider !== options.submenu) {
+                lazySubmenu.provider = options.submenu;
+                // Loaded again by the new provider the next time it is shown
+                if (lazySubmenu.isLoaded && lazySubmenu.shownCount === 0) {
+                    this.dropLazySubmenu_(lazySubmenu);
+                }
+            }
+        }
+        else if (this.submenu_ != null && !(options.submenu instanceof Menu)) {
+            this.submenu_['patchItems_'](options.submenu || [], patches);
+        }
+    }
+    /** @internal */
+    private setLabel_(label: string, patches: TemplatePatches): void {
+        if (label !== this.label_) {
+            this.label_ = label;
+            this.pushPatch_(patches, TemplatePatchCode.setLabel, label);
+        }
+    }
+    /** @internal */
+    private pushPatch_(patches: TemplatePatches, code: number, value: string | boolean): void {
+        for (const [nativeId, [template, itemId]] of this.templateNatives_) {
+            patchesOf(patches, nativeId, template).push(code, itemId, value);
+        }
+    }
 
-        return native;
+    /** @internal */
+    private handleSubmenuShow_(): void {
+        const lazySubmenu = this.lazySubmenu_;
+        if (lazySubmenu == null) return;
+        ++lazySubmenu.shownCount;
+        if (lazySubmenu.isStale) {
+            this.dropLazySubmenu_(lazySubmenu);
+        }
+        if (lazySubmenu.isLoaded) return;
+        lazySubmenu.isLoaded = true;
+        // Never rejects. A failed submenu is loaded again the next time it is shown.
+        this.loadLazySubmenu_(lazySubmenu, ++lazySubmenu.generation);
+    }
+    /** @internal */
+    private handleSubmenuHide_(): void {
+        const lazySubmenu = this.lazySubmenu_;
+        if (lazySubmenu == null || lazySubmenu.shownCount === 0) return;
+        --lazySubmenu.shownCount;
+        if (lazySubmenu.shownCount === 0 && lazySubmenu.isLoaded && !lazySubmenu.retains) {
+            lazySubmenu.isStale = true;
+        }
+    }
+    /** @internal */
+    private dropLazySubmenu_(lazySubmenu: LazySubmenu): void {
+        ++lazySubmenu.generation;
+        lazySubmenu.isLoaded = false;
+        lazySubmenu.isStale = false;
+        this.submenu_!['resetLazyItems_'](lazySubmenu.placeholder);
+    }
+    /** @internal */
+    private async loadLazySubmenu_(lazySubmenu: LazySubmenu, generation: number): Promise<void> {
+        const submenu = this.submenu_!;
+        const isCurrent = () => lazySubmenu.generation === generation;
+        // Nothing (null or undefined) is an empty submenu
+        const append = (items: MenuTemplate | null | undefined) => {
+            if (items != null) {
+                submenu['appendLazyItems_'](items, lazySubmenu.placeholder);
+            }
+        };
+        let placeholderLabel = kLazySubmenuEmptyLabel;
+        try {
+            const result = lazySubmenu.provider();
+            if (result == null || Array.isArray(result)) {
+                append(result);
+            }
+            else if (Symbol.asyncIterator in result) {
+                // Breaking out closes the iterator, so the provider can stop fetching the pages
+                for await (const page of result as AsyncIterable<MenuTemplate>) {
+                    if (!isCurrent()) break;
+                    append(page);
+                }
+            }
+            else {
+                const items = await result;
+                if (isCurrent()) {
+                    append(items);
+                }
+            }
+        }
+        catch (e) {
+            // Reported as a warning instead of an unhandled rejection, which would end the app
+            process.emitWarning(e instanceof Error ? e : new Error(`The lazy submenu of "${this.label_}" failed to load: ${e}`));
+            if (!isCurrent()) return;
+            this.dropLazySubmenu_(lazySubmenu);
+            placeholderLabel = kLazySubmenuFailedLabel;
+        }
+        if (isCurrent() && submenu.items.length === 1 && submenu.items[0] === lazySubmenu.placeholder) {
+            const patches: TemplatePatches = new Map();
+            lazySubmenu.placeholder['setLabel_'](placeholderLabel, patches);
+            sendPatches(patches);
+        }
     }
 
     /** @internal */
-    private destroyNative_(nativeId: number): void {
-        const native = this.natives_.get(nativeId)!;
-        native.destroy();
-        this.natives_.delete(nativeId);
-        if (this.submenu_ != null) {
-            this.submenu_['destroyNative_'](nativeId);
+    private handleClick_(window: BrowserWindow | null): void {
+        if (this.type_ === MenuItemTypeCode.checkbox) {
+            this.checked = !this.checked;
+        }
+        if (this.click != null) {
+            this.click(this, window || globals.focusedBrowserWindow);
         }
     }
 };
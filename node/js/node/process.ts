@@ -1,4 +1,5 @@
 import { appNative } from "./internal/native";
+import { isMainThread } from 'worker_threads';
 // @ts-expect-error
 import deskgapVersion from '../../VERSION.txt';
 
@@ -15,7 +16,9 @@ declare global {
 }
 
 process.resourcesPath = appNative.getResourcePath();
-process.argv = appNative.getArgv();
+if (isMainThread) {
+    process.argv = appNative.getArgv();
+}
 
 Object.defineProperty(process.versions, 'deskgap', {
     value: deskgapVersion,
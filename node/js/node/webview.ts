@@ -3,7 +3,11 @@ import appPath from './internal/app-path';
 import path = require('path');
 import globals from './internal/globals';
 import JSONTalk, { IServices, IServiceClient } from 'json-talk'
-import { WebViewNative } from './internal/native';
+import { performance } from 'perf_hooks';
+import { WebViewNative, BrowserWindowNative, BrowserWindowNativeCallbacks, MessageQueueStats, NativeIpcStats } from './internal/native';
+import { bulkUISync } from './internal/dispatch';
+import { recordStartupMilestone } from './internal/startup-trace';
+import { app } from './app';
 
 const isWinRTEngineAvailable = process.platform === 'win32' && WebViewNative.isWinRTEngineAvailable();
 const webview2Version = process.platform === 'win32' ? WebViewNative.getWebview2Version() : "";
@@ -23,14 +27,58 @@ const engineCodeByName: Record<Engine, number> = {
 export interface WebViewEvents extends IEventMap {
     'did-finish-load': [];
     'page-title-updated': [string];
+    'binary-message': [Buffer];
+    'drain': [];
+    'ipc-stats': [IpcStats];
 }
 
+export interface IpcStats extends NativeIpcStats {
+    /** Milliseconds spent in `JSON.stringify` for the messages to the page */
+    totalSerializationTime: number;
+    /** Milliseconds spent in `JSON.parse` for the messages from the page */
+    totalDeserializationTime: number;
+}
+
+// Platforms without a native binary channel send base64 strings with this prefix through the string channel.
+// JSON messages never start with it. Keep in sync with ui/preload.ts.
+const binaryMessagePrefix = '#';
+
 export interface WebPreferences {
     engine: Engine | null;
+    /**
+     * Serve local files with the COOP/COEP headers, so `SharedArrayBuffer` and threaded WebAssembly are available.
+     * Linux only, and requires WebKitGTK 2.36 or later.
+     */
+    crossOriginIsolated: boolean;
+    /**
+     * Windows with the same partition share one web context, which means one network process, one cache,
+     * and, where WebKitGTK allows it, one web process. `null` gives the window a context of its own.
+     * Linux only.
+     */
+    partition: string | null;
+}
+
+export type CacheModel = 'document-viewer' | 'document-browser' | 'web-browser';
+
+const cacheModelCodeByName: Record<CacheModel, number> = {
+    'document-viewer': 0,
+    'document-browser': 1,
+    'web-browser': 2,
+};
+
+export interface WebContextOptions {
+    cacheModel?: CacheModel;
+    /** Ignored by WebKitGTK 2.26 and later. 0 means no limit. */
+    webProcessCountLimit?: number;
 }
 
 let currentId = 0;
 
+interface WebViewCallbacks {
+    onPageTitleUpdated: (title: string) => void;
+    onReadyToShow: () => void;
+}
+
 export class WebView<Services extends IServices = any> extends EventEmitter<WebViewEvents> {
     /** @internal */ private id_: number;
     /** @internal */ private native_: WebViewNative;
@@ -39,38 +87,78 @@ export class WebView<Services extends IServices = any> extends EventEmitter<WebV
     /** @internal */ private asyncNodeObjectsById_ = new Map<number, any>();
     /** @internal */ private asyncNodeValuesByName_ = new Map<string, any>();
     /** @internal */ private isDevToolsEnabled_: boolean = false;
+    /** @internal */ private callbacks_: WebViewCallbacks;
+    /** @internal */ private isWarmingUp_: boolean = false;
+    /** @internal */ private isSendQueueFull_: boolean = false;
+    /** @internal */ private isFlushScheduled_: boolean = false;
+    /** @internal */ private serializationTime_ = 0;
+    /** @internal */ private deserializationTime_ = 0;
+    /** @internal */ private ipcStatsTimer_: NodeJS.Timeout | null = null;
+    /** @internal */ private measuresSerializationTime_ = false;
 
     #jsonTalk: JSONTalk<Services>;
     #jsonTalkServices: IServices;
 
     constructor(
-        callbacks: { onPageTitleUpdated: (title: string) => void, onReadyToShow: () => void },
+        callbacks: WebViewCallbacks,
         preferences: WebPreferences,
     ) {
         super();
         this.id_ = currentId;
         currentId++;
+        // Replaced when a pooled WebView is handed to a window
+        this.callbacks_ = callbacks;
 
         this.engine_ = preferences.engine || defaultEngine;
 
         this.#jsonTalkServices = {};
         this.#jsonTalk = new JSONTalk<Services>((message) => {
-            this.native_.executeJavaScript(`window.deskgap.__messageReceived(${JSON.stringify(message)})`, null);
+            if (!this.measuresSerializationTime_) {
+                this.queueMessage_(JSON.stringify(message));
+                return;
+            }
+            const serializationStart = performance.now();
+            const json = JSON.stringify(message);
+            this.serializationTime_ += performance.now() - serializationStart;
+            this.queueMessage_(json);
         }, this.#jsonTalkServices);
 
         this.native_ = new WebViewNative({
             didFinishLoad: () => {
+                if (!this.isWarmingUp_) {
+                    recordStartupMilestone('firstDidFinishLoad');
+                }
                 if (this.isDestroyed()) return;
                 try {
                     this.trigger_('did-finish-load');
                 }
                 finally {
-                    callbacks.onReadyToShow();
+                    this.callbacks_.onReadyToShow();
                 }
             },
             onStringMessage: (stringMessage: string) => {
                 if (this.isDestroyed()) return;
-                this.#jsonTalk.feedMessage(JSON.parse(stringMessage));
+                if (stringMessage.startsWith(binaryMessagePrefix)) {
+                    this.trigger_('binary-message', null, Buffer.from(stringMessage.substring(binaryMessagePrefix.length), 'base64'));
+                    return;
+                }
+                if (!this.measuresSerializationTime_) {
+                    this.#jsonTalk.feedMessage(JSON.parse(stringMessage));
+                    return;
+                }
+                const deserializationStart = performance.now();
+                const message = JSON.parse(stringMessage);
+                this.deserializationTime_ += performance.now() - deserializationStart;
+                this.#jsonTalk.feedMessage(message);
+            },
+            onBinaryMessage: (binaryMessage: Buffer) => {
+                if (this.isDestroyed()) return;
+                this.trigger_('binary-message', null, binaryMessage);
+            },
+            onMessageQueueDrain: () => {
+                if (this.isDestroyed()) return;
+                this.isSendQueueFull_ = false;
+                this.trigger_('drain');
             },
             onPageTitleUpdated: (title: string) => {
                 try {
@@ -78,10 +166,84 @@ export class WebView<Services extends IServices = any> extends EventEmitter<WebV
                     this.trigger_('page-title-updated', null, title);
                 }
                 finally {
-                    callbacks.onPageTitleUpdated(title);
+                    this.callbacks_.onPageTitleUpdated(title);
                 }
             }
-        }, this.engine_ == null ? null : engineCodeByName[this.engine_]);
+        }, this.engine_ == null ? null : engineCodeByName[this.engine_], preferences.partition);
+
+        if (preferences.crossOriginIsolated && process.platform === 'linux') {
+            this.native_.setCrossOriginIsolated(true);
+        }
+    }
+
+    /** @internal */
+    private queueMessage_(json: string): void {
+        if (!this.native_.queueMessage(json)) {
+            this.isSendQueueFull_ = true;
+        }
+        // Flushed on the next turn, so the messages of one turn, including those sent
+        // from promise callbacks, are delivered to the page by a single script.
+        if (!this.isFlushScheduled_) {
+            this.isFlushScheduled_ = true;
+            setImmediate(() => {
+                this.isFlushScheduled_ = false;
+                if (this.isDestroyed()) return;
+                this.native_.flushMessages();
+            });
+        }
+    }
+
+    /**
+     * Whether the messages to the page that are queued or being delivered have reached the high-water mark.
+     * The `'drain'` event is emitted when they fall below it again.
+     */
+    isSendQueueFull(): boolean {
+        return this.isSendQueueFull_;
+    }
+
+    /** Sets the high-water mark of the messages to the page, in bytes of JSON. Defaults to 1 MiB. */
+    setSendHighWaterMark(bytes: number): void {
+        this.native_.setMessageQueueHighWaterMark(bytes);
+    }
+
+    getSendQueueStats(): MessageQueueStats {
+        return this.native_.getMessageQueueStats();
+    }
+
+    /**
+     * Counters of the messages between node and the page since the WebView was created.
+     * `totalSerializationTime` and `totalDeserializationTime` only grow while `setIpcStatsEnabled(true)`
+     * or `setIpcStatsInterval(ms)` is in effect, as timing every message is not free.
+     */
+    getIpcStats(): IpcStats {
+        return Object.assign(this.native_.getIpcStats(), {
+            totalSerializationTime: this.serializationTime_,
+            totalDeserializationTime: this.deserializationTime_,
+        });
+    }
+
+    /** Times the JSON serialization of the messages, which is off by default. */
+    setIpcStatsEnabled(enabled: boolean): void {
+        this.measuresSerializationTime_ = enabled;
+    }
+
+    /** Emits `'ipc-stats'` every `interval` milliseconds, and enables the timing of `setIpcStatsEnabled`. 0 stops both. */
+    setIpcStatsInterval(interval: number): void {
+        if (this.ipcStatsTimer_ != null) {
+            clearInterval(this.ipcStatsTimer_);
+            this.ipcStatsTimer_ = null;
+        }
+        this.measuresSerializationTime_ = interval > 0;
+        if (interval <= 0) return;
+
+        this.ipcStatsTimer_ = setInterval(() => {
+            if (this.isDestroyed()) {
+                this.setIpcStatsInterval(0);
+                return;
+            }
+            this.trigger_('ipc-stats', null, this.getIpcStats());
+        }, interval);
+        this.ipcStatsTimer_.unref();
     }
 
     publishServices(services: IServices) {
@@ -92,6 +254,24 @@ export class WebView<Services extends IServices = any> extends EventEmitter<WebV
         return this.#jsonTalk.connectService(serviceName)
     }
 
+    /**
+     * Sends the bytes to the page, where they arrive as an `ArrayBuffer` in the listeners of `window.deskgap.onBinaryMessage`.
+     * On Linux the bytes are pulled by the page directly, without being encoded into a script.
+     */
+    sendBinary(data: ArrayBuffer | ArrayBufferView): void {
+        if (!ArrayBuffer.isView(data) && !(data instanceof ArrayBuffer)) {
+            throw new TypeError('The data must be an ArrayBuffer or an ArrayBufferView');
+        }
+        const view = ArrayBuffer.isView(data) ? data : new Uint8Array(data);
+        if (process.platform === 'linux') {
+            this.native_.postBinaryMessage(view);
+        }
+        else {
+            const base64 = Buffer.from(view.buffer, view.byteOffset, view.byteLength).toString('base64');
+            this.native_.executeJavaScript(`window.deskgap.__binaryMessageReceived(${JSON.stringify(base64)})`, null);
+        }
+    }
+
     get id(): number {
         return this.id_;
     }
@@ -126,9 +306,149 @@ export class WebView<Services extends IServices = any> extends EventEmitter<WebV
     reload(): void {
         this.native_.reload();
     }
+
+    /** @internal Destroys the native WebView, after which isDestroyed() is true. The window is destroyed by its owner. */
+    private destroy_(): void {
+        this.setIpcStatsInterval(0);
+        this.native_.destroy();
+        this.native_ = null;
+    }
+}
+
+/** @internal A hidden native window whose WebView has loaded about:blank, ready to be taken by a BrowserWindow */
+export interface PooledWindow {
+    webView: WebView;
+    native: BrowserWindowNative;
 }
 
+interface PoolEntry extends PooledWindow {
+    /** Replaced by the callbacks of the BrowserWindow that takes the window */
+    windowCallbacks: BrowserWindowNativeCallbacks;
+}
+
+// The WebViews are created ahead of time in hidden windows, because a WebView only loads a page,
+// and on Windows only has a page to load into, once it is attached to a window.
+// The web process and the preload script are then ready when a BrowserWindow takes one.
+const pool = {
+    size: 0,
+    warmEntries: <PoolEntry[]>[],
+    warmingUpCount: 0,
+};
+
+const noopWebViewCallbacks: WebViewCallbacks = {
+    onPageTitleUpdated: () => {},
+    onReadyToShow: () => {},
+};
+
+const noopWindowCallbacks: BrowserWindowNativeCallbacks = {
+    onBlur: () => {},
+    onFocus: () => {},
+    onResize: () => {},
+    onMove: () => {},
+    onClose: () => {},
+};
+
+const destroyPoolEntry = (entry: PoolEntry): void => {
+    bulkUISync(() => {
+        entry.webView['destroy_']();
+        entry.native.destroy();
+    });
+    entry.native = null;
+};
+
+const fillPool = () => {
+    if (!app.isReady() || pool.warmEntries.length + pool.warmingUpCount >= pool.size) return;
+
+    bulkUISync(() => {
+        const webView = new WebView(noopWebViewCallbacks, { engine: defaultEngine, crossOriginIsolated: false, partition: null });
+        const entry: PoolEntry = {
+            webView,
+            native: null,
+            windowCallbacks: noopWindowCallbacks,
+        };
+        entry.native = new BrowserWindowNative(webView['native_'], {
+            onBlur: () => entry.windowCallbacks.onBlur(),
+            onFocus: () => entry.windowCallbacks.onFocus(),
+            onResize: () => entry.windowCallbacks.onResize(),
+            onMove: () => entry.windowCallbacks.onMove(),
+            onClose: () => entry.windowCallbacks.onClose(),
+        });
+
+        pool.warmingUpCount++;
+        webView['isWarmingUp_'] = true;
+        webView['callbacks_'] = {
+            onPageTitleUpdated: () => {},
+            onReadyToShow: () => {
+                webView['callbacks_'] = noopWebViewCallbacks;
+                webView['isWarmingUp_'] = false;
+                pool.warmingUpCount--;
+                if (pool.warmEntries.length < pool.size) {
+                    pool.warmEntries.push(entry);
+                }
+                else {
+                    destroyPoolEntry(entry);
+                }
+                setTimeout(fillPool, 0);
+            }
+        };
+        webView.loadURL('about:blank');
+    });
+};
+
+/** @internal Hands a warm window of the pool over to a BrowserWindow, with the callbacks of the BrowserWindow */
+export const takePooledWindow = (
+    webViewCallbacks: WebViewCallbacks, windowCallbacks: BrowserWindowNativeCallbacks, preferences: WebPreferences
+): PooledWindow | null => {
+    if (preferences.crossOriginIsolated || preferences.partition != null) return null;
+    // The default engine may have been changed after the WebView was created.
+    const engine = preferences.engine || defaultEngine;
+    const index = pool.warmEntries.findIndex((entry) => entry.webView.engine === engine);
+    if (index < 0) return null;
+
+    const [entry] = pool.warmEntries.splice(index, 1);
+
+    entry.webView['callbacks_'] = webViewCallbacks;
+    entry.windowCallbacks = windowCallbacks;
+    // Refilled on a later turn, so creating the replacement does not delay the window taking this one.
+    setTimeout(fillPool, 0);
+    return entry;
+};
+
 export const WebViews = {
+    /**
+     * Keeps `size` hidden windows with a WebView loaded in the background, which new `BrowserWindow`s take
+     * instead of creating their own, as long as they use the default engine and do not set `crossOriginIsolated` or `partition`.
+     * The pool is refilled asynchronously. Defaults to 0, which disables the pool.
+     */
+    setPoolSize(size: number): void {
+        pool.size = size;
+        while (pool.warmEntries.length > size) {
+            destroyPoolEntry(pool.warmEntries.pop()!);
+        }
+        app.whenReady().then(() => setTimeout(fillPool, 0));
+    },
+
+    getPoolSize(): number {
+        return pool.size;
+    },
+
+    /** The WebViews of the pool that have loaded and are ready to be taken */
+    getPooledWebViewCount(): number {
+        return pool.warmEntries.length;
+    },
+
+    /**
+     * Tunes the web contexts created afterwards. Linux only.
+     * `cacheModel` defaults to `'web-browser'`; `'document-viewer'` keeps the smallest memory cache.
+     */
+    setContextOptions(options: WebContextOptions): void {
+        if (process.platform !== 'linux') return;
+        WebViewNative.setContextOptions(
+            cacheModelCodeByName[options.cacheModel || 'web-browser'],
+            options.webProcessCountLimit || 0,
+        );
+    },
+
     getAllWebViews(): WebView[] {
         return Array.from(globals.webViewsById.values());
     },
@@ -0,0 +1,33 @@
+import worker_threads = require('worker_threads');
+import path = require('path');
+import url = require('url');
+import { app } from './app';
+
+/**
+ * A `worker_threads` Worker in which `require('deskgap')` works.
+ * 
+ * Each worker has its own bindings, so it can create windows and exchange messages with their pages directly,
+ * instead of bouncing every message through the main thread.
+ * Windows created by a worker belong to it: they are not in `BrowserWindow.getAllWindows()` of the main thread,
+ * and closing them does not emit `window-all-closed`.
+ * 
+ * Can only be created after the app is ready.
+ * 
+ * Thread: Node
+ */
+export class Worker extends worker_threads.Worker {
+    constructor(filename: string | URL, options: worker_threads.WorkerOptions = {}) {
+        if (!app.isReady()) {
+            throw new Error('A Worker can only be created after the app is ready');
+        }
+        const entry = filename instanceof URL ? url.fileURLToPath(filename) : path.resolve(filename);
+        // Mirrors kBootstrapScript in main.cc. The bundle is read from the bindings, which are linked for the whole process.
+        const bootstrapScript = `
+            globalThis.require = require('module').createRequire(process.execPath);
+            globalThis.__embedder_mod = process._linkedBinding('__embedder_mod');
+            require('vm').runInThisContext(globalThis.__embedder_mod.getNodeScript(), { filename: 'builtin:dg_node.js' });
+            require(${JSON.stringify(entry)});
+        `;
+        super(bootstrapScript, { ...options, eval: true });
+    }
+}
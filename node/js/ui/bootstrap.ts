@@ -6,6 +6,11 @@ interface InternalDeskGap {
     platform: string;
     postStringMessage: (message: string) => void;
 
+    //Only defined on platforms with a native binary channel (Linux).
+    postBinaryMessage?: (arrayBuffer: ArrayBuffer) => void;
+    receiveBinaryMessages?: () => void;
+    binaryMessageReceived?: ((arrayBuffer: ArrayBuffer) => void) | null;
+
     //This is to be defined in this file.
     messageReceived: (channelName: string, args: any[]) => void;
 }
@@ -6,6 +6,17 @@ const jsonTalk = new JSONTalk<any>((message) => {
     internalDeskGap.postStringMessage(JSON.stringify(message));
 }, jsonTalkServices);
 
+// Keep in sync with node/webview.ts
+const binaryMessagePrefix = '#';
+
+const binaryMessageListeners: Array<(data: ArrayBuffer) => void> = [];
+const dispatchBinaryMessage = (data: ArrayBuffer) => {
+    for (const listener of binaryMessageListeners.slice()) {
+        listener(data);
+    }
+};
+internalDeskGap.binaryMessageReceived = dispatchBinaryMessage;
+
 export class DeskGapInBroswer<Services extends IServices> {
     readonly platform = <'darwin' | 'win32' | 'linux'>internalDeskGap.platform;
     publishServices(services: IServices) {
@@ -17,6 +28,38 @@ export class DeskGapInBroswer<Services extends IServices> {
     getService<ServiceName extends (keyof Services & string)>(serviceName: ServiceName): IServiceClient<Services[ServiceName]> {
         return jsonTalk.connectService(serviceName)
     }
+    postBinaryMessage(data: ArrayBuffer | ArrayBufferView) {
+        let arrayBuffer: ArrayBuffer;
+        if (data instanceof ArrayBuffer) {
+            arrayBuffer = data;
+        }
+        else if (data.byteOffset === 0 && data.byteLength === data.buffer.byteLength) {
+            arrayBuffer = data.buffer as ArrayBuffer;
+        }
+        else {
+            arrayBuffer = data.buffer.slice(data.byteOffset, data.byteOffset + data.byteLength) as ArrayBuffer;
+        }
+
+        if (internalDeskGap.postBinaryMessage != null) {
+            internalDeskGap.postBinaryMessage(arrayBuffer);
+            return;
+        }
+        const bytes = new Uint8Array(arrayBuffer);
+        let binaryString = '';
+        for (let i = 0; i < bytes.length; i++) {
+            binaryString += String.fromCharCode(bytes[i]);
+        }
+        internalDeskGap.postStringMessage(binaryMessagePrefix + btoa(binaryString));
+    }
+    onBinaryMessage(listener: (data: ArrayBuffer) => void) {
+        binaryMessageListeners.push(listener);
+    }
+    removeBinaryMessageListener(listener: (data: ArrayBuffer) => void) {
+        const index = binaryMessageListeners.indexOf(listener);
+        if (index !== -1) {
+            binaryMessageListeners.splice(index, 1);
+        }
+    }
 }
 
 declare global {
@@ -31,3 +74,40 @@ window.deskgap = new DeskGapInBroswer();
 Object.defineProperty(window.deskgap, "__messageReceived", {
     value: (msg: any) => { jsonTalk.feedMessage(msg) }
 });
+
+// Called with the messages batched by WebViewWrap::MessageQueue
+Object.defineProperty(window.deskgap, "__messagesReceived", {
+    value: (messages: any[]) => {
+        for (const msg of messages) {
+            try {
+                jsonTalk.feedMessage(msg);
+            }
+            catch (e) {
+                // Reported like an uncaught error, without dropping the rest of the batch
+                setTimeout(() => { throw e; });
+            }
+        }
+    }
+});
+
+// Called by WebView::PostBinaryMessage on Linux, the messages are then fetched by internalDeskGap.
+Object.defineProperty(window.deskgap, "__binaryMessagesAvailable", {
+    value: () => { internalDeskGap.receiveBinaryMessages!() }
+});
+
+// Base64 fallback of webview.ts for other platforms
+Object.defineProperty(window.deskgap, "__binaryMessageReceived", {
+    value: (base64: string) => {
+        const binaryString = atob(base64);
+        const bytes = new Uint8Array(binaryString.length);
+        for (let i = 0; i < binaryString.length; i++) {
+            bytes[i] = binaryString.charCodeAt(i);
+        }
+        dispatchBinaryMessage(bytes.buffer);
+    }
+});
+
+// Collect the messages queued before the page was loaded.
+if (internalDeskGap.receiveBinaryMessages != null) {
+    internalDeskGap.receiveBinaryMessages();
+}
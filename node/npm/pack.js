@@ -0,0 +1,106 @@
+#!/usr/bin/env node
+
+// Packs a directory into an asset archive that the deskgap-local scheme can serve
+// without touching the file system per request:
+//     deskgap-pack <source directory> <output>.dgpack
+// and then `browserWindow.loadFile('<output>.dgpack/index.html')`.
+//
+// Layout (little-endian), read by lib/src/utils/asset_archive.hpp:
+//     header:     "DGPK", u32 version, u32 entry count, u32 path table size
+//     entries:    u32 path offset, u32 path length, u64 data offset, u64 stored size, u32 compression, u32 reserved
+//                 sorted by the UTF-8 bytes of their paths
+//     path table: the paths, '/'-separated and relative to the source directory
+//     data:       the contents, each one either stored as it is or gzipped
+
+const fs = require('fs');
+const path = require('path');
+const zlib = require('zlib');
+
+const MAGIC = 'DGPK';
+const VERSION = 1;
+const HEADER_SIZE = 16;
+const ENTRY_SIZE = 32;
+
+const Compression = {
+    NONE: 0,
+    GZIP: 1
+};
+
+const compressibleExtensions = new Set([
+    'css', 'csv', 'htm', 'html', 'js', 'json', 'map', 'md', 'mjs',
+    'svg', 'txt', 'wasm', 'xhtml', 'xml'
+]);
+
+const listFiles = (rootDir, relativeDir = '') => {
+    const files = [];
+    for (const dirent of fs.readdirSync(path.join(rootDir, relativeDir), { withFileTypes: true })) {
+        const relativePath = relativeDir === '' ? dirent.name : `${relativeDir}/${dirent.name}`;
+        if (dirent.isDirectory()) {
+            files.push(...listFiles(rootDir, relativePath));
+        }
+        else if (dirent.isFile()) {
+            files.push(relativePath);
+        }
+    }
+    return files;
+};
+
+const packAssets = (sourceDir, outputPath) => {
+    const entries = listFiles(sourceDir)
+        .map((relativePath) => {
+            const pathBytes = Buffer.from(relativePath, 'utf8');
+            let data = fs.readFileSync(path.join(sourceDir, relativePath));
+            let compression = Compression.NONE;
+
+            const extension = path.extname(relativePath).slice(1).toLowerCase();
+            if (compressibleExtensions.has(extension)) {
+                const compressed = zlib.gzipSync(data, { level: zlib.constants.Z_BEST_COMPRESSION });
+                if (compressed.length < data.length) {
+                    data = compressed;
+                    compression = Compression.GZIP;
+                }
+            }
+            return { pathBytes, data, compression };
+        })
+        .sort((a, b) => Buffer.compare(a.pathBytes, b.pathBytes));
+
+    const pathTableSize = entries.reduce((size, entry) => size + entry.pathBytes.length, 0);
+    const header = Buffer.alloc(HEADER_SIZE + ENTRY_SIZE * entries.length);
+    header.write(MAGIC, 0, 'ascii');
+    header.writeUInt32LE(VERSION, 4);
+    header.writeUInt32LE(entries.length, 8);
+    header.writeUInt32LE(pathTableSize, 12);
+
+    let pathOffset = 0;
+    let dataOffset = header.length + pathTableSize;
+    entries.forEach((entry, i) => {
+        const entryOffset = HEADER_SIZE + ENTRY_SIZE * i;
+        header.writeUInt32LE(pathOffset, entryOffset);
+        header.writeUInt32LE(entry.pathBytes.length, entryOffset + 4);
+        header.writeBigUInt64LE(BigInt(dataOffset), entryOffset + 8);
+        header.writeBigUInt64LE(BigInt(entry.data.length), entryOffset + 16);
+        header.writeUInt32LE(entry.compression, entryOffset + 24);
+
+        pathOffset += entry.pathBytes.length;
+        dataOffset += entry.data.length;
+    });
+
+    fs.writeFileSync(outputPath, Buffer.concat([
+        header,
+        ...entries.map((entry) => entry.pathBytes),
+        ...entries.map((entry) => entry.data)
+    ]));
+    return entries.length;
+};
+
+module.exports = packAssets;
+
+if (require.main === module) {
+    const [sourceDir, outputPath] = process.argv.slice(2);
+    if (sourceDir == null || outputPath == null) {
+        console.error('Usage: deskgap-pack <source directory> <output>.dgpack');
+        process.exit(1);
+    }
+    const entryCount = packAssets(sourceDir, outputPath);
+    console.log(`Packed ${entryCount} files into ${outputPath}`);
+}
@@ -3,8 +3,11 @@
 #include "deskgap/argv.hpp"
 #include "napi.h"
 #include "node_bindings/app/app_startup.hpp"
+#include "node_bindings/app/node_options.hpp"
+#include "node_bindings/app/startup_trace.hpp"
 #include "node_bindings/index.hpp"
 #include "node_embedding_api.h"
+#include <cstdio>
 #include <memory>
 #include <thread>
 #include <utility>
@@ -17,8 +20,11 @@
 
 extern "C" {
 extern char BIN2CODE_DG_NODE_JS_CONTENT[];
+extern const char DG_NODE_JS_HASH[];
 }
 namespace {
+    using DeskGap::StartupTrace;
+
     Semaphore appRunSemaphore;
     std::vector<std::string> execArgs;
     std::string resourcePath;
@@ -28,6 +34,53 @@ namespace {
 
 
 namespace {
+    // Evaluates dg_node.js (passed as argv[1]) with a V8 code cache kept in the per-user cache folder,
+    // so the bundle is not parsed and compiled from scratch on every launch.
+    // The cache is keyed by the V8 version and the SHA-1 of the bundle, which is computed at build time
+    // and passed as argv[2], so the bundle is not hashed on every launch. It is rewritten when V8 rejects it
+    // (for example, after the V8 flags change). It is written after the first turn of the event loop,
+    // so the functions compiled while starting up are included. Set DESKGAP_NO_CODE_CACHE to disable it.
+    const char* kBootstrapScript = R"JS(
+        globalThis.require = require('module').createRequire(process.execPath);
+        globalThis.__embedder_mod = process._linkedBinding('__embedder_mod');
+        const content = process.argv[1];
+        const contentHash = process.argv[2];
+        const vm = require('vm');
+        const filename = 'builtin:dg_node.js';
+
+        let cachePath = null;
+        let cachedData = undefined;
+        if (!process.env.DESKGAP_NO_CODE_CACHE) {
+            try {
+                const fs = require('fs');
+                const os = require('os');
+                const path = require('path');
+                const cacheDir = process.platform === 'win32' ? path.join(process.env.LOCALAPPDATA || os.tmpdir(), 'DeskGap', 'CodeCache')
+                    : process.platform === 'darwin' ? path.join(os.homedir(), 'Library', 'Caches', 'DeskGap', 'CodeCache')
+                    : path.join(process.env.XDG_CACHE_HOME || path.join(os.homedir(), '.cache'), 'deskgap', 'code-cache');
+                cachePath = path.join(cacheDir, `dg_node-${process.versions.v8}-${contentHash}.cache`);
+                cachedData = fs.readFileSync(cachePath);
+            }
+            catch (e) { }
+        }
+
+        const script = new vm.Script(content, { filename, cachedData });
+        if (cachePath != null && (cachedData === undefined || script.cachedDataRejected)) {
+            setImmediate(() => {
+                try {
+                    const fs = require('fs');
+                    const path = require('path');
+                    fs.mkdirSync(path.dirname(cachePath), { recursive: true });
+                    const temporaryPath = `${cachePath}.${process.pid}`;
+                    fs.writeFileSync(temporaryPath, script.createCachedData());
+                    fs.renameSync(temporaryPath, cachePath);
+                }
+                catch (e) { }
+            });
+        }
+        script.runInThisContext();
+    )JS";
+
     char* join_errors(const std::vector<std::string>& errors) {
         std::string joined_error;
         for (std::size_t i = 0; i < errors.size(); ++i) {
@@ -56,9 +109,9 @@ namespace {
     node_run_result_t RunNodeInstance(
         node::MultiIsolatePlatform* platform,
         const std::vector<std::string>& args,
-        const std::vector<std::string>& exec_args,
-        napi_addon_register_func napi_reg_func
+        const std::vector<std::string>& exec_args
     ) {
+        StartupTrace::Record("environmentSetup", StartupTrace::Phase::BEGIN, StartupTrace::Thread::NODE);
         std::vector<std::string> errors;
         std::unique_ptr<node::CommonEnvironmentSetup> setup =
             node::CommonEnvironmentSetup::Create(
@@ -88,22 +141,13 @@ namespace {
             v8::HandleScope handle_scope(isolate);
             v8::Context::Scope context_scope(setup->context());
 
-            node::AddLinkedBinding(env, napi_module {
-                NAPI_MODULE_VERSION,
-                node::ModuleFlags::kLinked,
-                nullptr,
-                napi_reg_func,
-                "__embedder_mod",
-                nullptr,
-                {0},
-            });
+            StartupTrace::Record("environmentSetup", StartupTrace::Phase::END, StartupTrace::Thread::NODE);
 
+            // Ended by the bundle itself, right before it requires the entry of the app
+            StartupTrace::Record("bundleEval", StartupTrace::Phase::BEGIN, StartupTrace::Thread::NODE);
             v8::MaybeLocal<v8::Value> loadenv_ret = node::LoadEnvironment(
                 env,
-                "globalThis.require = require('module').createRequire(process.execPath);"
-                "globalThis.__embedder_mod = process._linkedBinding('__embedder_mod');"
-                "const content = process.argv[1];"
-                "require('vm').runInThisContext(content, { filename: 'builtin:dg_node.js' });"
+                kBootstrapScript
             );
 
             if (loadenv_ret.IsEmpty()) {  // There has been a JS exception.
@@ -121,6 +165,22 @@ namespace {
         return result;
     }
 
+    // Sets the flags before V8 is initialized. The ones that V8 does not know, or whose values it rejects, are left in argv
+    // and reported as errors, instead of making node::InitializeNodeWithArgs fail.
+    void SetV8Flags(const std::vector<std::string>& flags, std::vector<std::string>& errors) {
+        if (flags.empty()) return;
+        std::vector<std::string> flag_strings = flags;
+        std::vector<char*> argv { const_cast<char*>("deskgap") };
+        for (std::string& flag: flag_strings) {
+            argv.push_back(flag.data());
+        }
+        int argc = static_cast<int>(argv.size());
+        v8::V8::SetFlagsFromCommandLine(&argc, argv.data(), true);
+        for (int i = 1; i < argc; ++i) {
+            errors.push_back(std::string("V8 flag ") + argv[i] + ": Not a V8 flag, or an invalid value");
+        }
+    }
+
     node_run_result_t node_run2(node_options_t options) {
         std::vector<std::string> process_args = create_arg_vec(options.process_argc, options.process_argv);
         if (process_args.empty()) {
@@ -128,12 +188,38 @@ namespace {
         } 
         std::vector<std::string> args { process_args[0] };
 
+        StartupTrace::Record("v8PlatformInit", StartupTrace::Phase::BEGIN, StartupTrace::Thread::NODE);
+
+        // The command line of the app is not parsed by Node. Only the options configured for it are.
+        std::vector<std::string> option_errors;
+        DeskGap::NodeOptions node_options = DeskGap::NodeOptions::Load(resourcePath, option_errors);
+        SetV8Flags(node_options.v8Flags, option_errors);
+        for (const std::string& error: option_errors) {
+            fprintf(stderr, "DeskGap: ignored an invalid option: %s\n", error.c_str());
+        }
+        node_options.ApplyToEnvironment();
+        std::vector<std::string> command_line_options = node_options.CommandLineOptions();
+        args.insert(args.end(), command_line_options.begin(), command_line_options.end());
+
+        // Linked before Node is initialized, the module is registered for the whole process instead of one Environment,
+        // so worker threads can get it by process._linkedBinding too.
+        static napi_module embedder_module {
+            NAPI_MODULE_VERSION,
+            node::ModuleFlags::kLinked,
+            nullptr,
+            options.napi_reg_func,
+            "__embedder_mod",
+            nullptr,
+            {0},
+        };
+        napi_module_register(&embedder_module);
+
         std::vector<std::string> exec_args;
         std::vector<std::string> errors;
         int exit_code = node::InitializeNodeWithArgs(
             &args, &exec_args, &errors,
             static_cast<node::ProcessFlags::Flags>(
-                node::ProcessFlags::kDisableCLIOptions |
+                (command_line_options.empty() ? node::ProcessFlags::kDisableCLIOptions : 0) |
                 node::ProcessFlags::kDisableNodeOptionsEnv
             )
         );
@@ -141,11 +227,12 @@ namespace {
         if (exit_code != 0) {
             return { exit_code, join_errors(errors) };
         }
-        std::unique_ptr<node::MultiIsolatePlatform> platform = node::MultiIsolatePlatform::Create(4);
+        std::unique_ptr<node::MultiIsolatePlatform> platform = node::MultiIsolatePlatform::Create(node_options.platformWorkerThreads);
         v8::V8::InitializePlatform(platform.get());
         v8::V8::Initialize();
+        StartupTrace::Record("v8PlatformInit", StartupTrace::Phase::END, StartupTrace::Thread::NODE);
 
-        node_run_result_t result = RunNodeInstance(platform.get(), process_args, exec_args, options.napi_reg_func);
+        node_run_result_t result = RunNodeInstance(platform.get(), process_args, exec_args);
 
         v8::V8::Dispose();
         v8::V8::ShutdownPlatform();
@@ -204,16 +291,21 @@ int wmain(int argc, const wchar_t **argv)
 int main(int argc, const char **argv)
 #endif
 {
+    StartupTrace::Start();
+
+    StartupTrace::Record("appInit", StartupTrace::Phase::BEGIN, StartupTrace::Thread::UI);
     DeskGap::App::Init();
+    StartupTrace::Record("appInit", StartupTrace::Phase::END, StartupTrace::Thread::UI);
 
     std::thread nodeThread([argc, argv]() {
         execArgs = DeskGap::Argv(argc, argv);
         const char *argv0 = execArgs[0].c_str();
         resourcePath = DeskGap::App::GetResourcePath(argv0);
-        exit(DeskGap::startNodeWithArgs({argv0, BIN2CODE_DG_NODE_JS_CONTENT}));
+        exit(DeskGap::startNodeWithArgs({argv0, BIN2CODE_DG_NODE_JS_CONTENT, DG_NODE_JS_HASH}));
     });
 
     appRunSemaphore.wait();
+    StartupTrace::Record("appRun", StartupTrace::Phase::INSTANT, StartupTrace::Thread::UI);
     DeskGap::App::Run(std::move(appEventCallbacks));
 
     return 0;
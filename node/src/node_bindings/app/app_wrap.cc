@@ -1,9 +1,12 @@
 #include "app_wrap.h"
 #include <deskgap/app.hpp>
+#include <deskgap/dispatch.hpp>
 #include "../dispatch/dispatch.h"
+#include "../env_data.h"
 #include "../menu/menu_wrap.h"
 #include "../util/js_native_convert.h"
 #include "app_startup.hpp"
+#include "startup_trace.hpp"
 
 
 Napi::Object DeskGap::AppWrap::AppObject(const Napi::Env& env) {
@@ -11,6 +14,9 @@ Napi::Object DeskGap::AppWrap::AppObject(const Napi::Env& env) {
 
     Napi::Object appObject = Napi::Object::New(env);
     appObject.Set("run", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        if (!EnvData::Of(info.Env()).isMainEnv) {
+            throw Napi::Error::New(info.Env(), "The app can only be run by the main thread");
+        }
         Napi::Object jsCallbacks = info[0].As<Napi::Object>();
         auto jsOnReady = JSFunctionForUI::Persist(jsCallbacks.Get("onReady").As<Napi::Function>());
         auto jsBeforeQuit = JSFunctionForUI::Persist(jsCallbacks.Get("beforeQuit").As<Napi::Function>());
@@ -88,6 +94,48 @@ Napi::Object DeskGap::AppWrap::AppObject(const Napi::Env& env) {
     }));
 #endif
 
+#ifdef __linux__
+    appObject.Set("getUIDispatchStats", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        DispatchStats stats = DeskGap::GetDispatchStats();
+        Napi::Object jsStats = Napi::Object::New(info.Env());
+        jsStats.Set("queueDepth", Napi::Number::New(info.Env(), stats.queueDepth));
+        jsStats.Set("maxQueueDepth", Napi::Number::New(info.Env(), stats.maxQueueDepth));
+        jsStats.Set("dispatchedActions", Napi::Number::New(info.Env(), stats.dispatchedActions));
+        jsStats.Set("wakeups", Napi::Number::New(info.Env(), stats.wakeups));
+        jsStats.Set("totalLatencyMicroseconds", Napi::Number::New(info.Env(), stats.totalLatencyMicroseconds));
+        jsStats.Set("maxLatencyMicroseconds", Napi::Number::New(info.Env(), stats.maxLatencyMicroseconds));
+        return jsStats;
+    }));
+#endif
+
+    appObject.Set("recordStartupPhase", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        std::string name = info[0].As<Napi::String>();
+        std::string phase = info[1].As<Napi::String>();
+        if (phase != "B" && phase != "E" && phase != "I") {
+            throw Napi::TypeError::New(info.Env(), "The phase must be 'B', 'E' or 'I'");
+        }
+        // The trace is of the process, which a worker does not start
+        if (!EnvData::Of(info.Env()).isMainEnv) {
+            return;
+        }
+        StartupTrace::Record(std::move(name), static_cast<StartupTrace::Phase>(phase[0]), StartupTrace::Thread::NODE);
+    }));
+
+    appObject.Set("getStartupTraceEvents", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        std::vector<StartupTrace::Event> events = StartupTrace::Events();
+        Napi::Array jsEvents = Napi::Array::New(info.Env(), events.size());
+        for (size_t i = 0; i < events.size(); ++i) {
+            const StartupTrace::Event& event = events[i];
+            Napi::Object jsEvent = Napi::Object::New(info.Env());
+            jsEvent.Set("name", Napi::String::New(info.Env(), event.name));
+            jsEvent.Set("ph", Napi::String::New(info.Env(), std::string(1, static_cast<char>(event.phase))));
+            jsEvent.Set("tid", Napi::Number::New(info.Env(), static_cast<int>(event.thread)));
+            jsEvent.Set("ts", Napi::Number::New(info.Env(), static_cast<double>(event.timestamp)));
+            jsEvents.Set(static_cast<uint32_t>(i), jsEvent);
+        }
+        return jsEvents;
+    }));
+
     appObject.Set("getPath", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
         std::string path = DeskGap::App::GetPath(static_cast<App::PathName>(Native<uint32_t>::From(info[0])));
         return JSFrom(info.Env(), path);
@@ -0,0 +1,322 @@
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include "node_options.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+    // Just enough JSON to read package.json before Node is running
+    struct JSONValue {
+        using Array = std::vector<JSONValue>;
+        using Object = std::vector<std::pair<std::string, JSONValue>>;
+        std::variant<std::nullptr_t, bool, double, std::string, Array, Object> value;
+
+        const JSONValue* Find(const std::string& key) const {
+            if (const Object* object = std::get_if<Object>(&value)) {
+                for (const auto& [memberKey, memberValue]: *object) {
+                    if (memberKey == key) return &memberValue;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    class JSONParser {
+    private:
+        const std::string& text_;
+        size_t position_ = 0;
+
+        [[noreturn]] void Fail(const char* expectation) {
+            throw std::runtime_error(std::string("Expected ") + expectation + " at offset " + std::to_string(position_));
+        }
+        void SkipSpaces() {
+            while (position_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[position_]))) {
+                ++position_;
+            }
+        }
+        bool Consume(char c) {
+            SkipSpaces();
+            if (position_ < text_.size() && text_[position_] == c) {
+                ++position_;
+                return true;
+            }
+            return false;
+        }
+        bool ConsumeWord(const char* word) {
+            size_t length = std::char_traits<char>::length(word);
+            if (text_.compare(position_, length, word) == 0) {
+                position_ += length;
+                return true;
+            }
+            return false;
+        }
+
+        static void AppendUTF8(std::string& result, uint32_t codePoint) {
+            if (codePoint < 0x80) {
+                result.push_back(static_cast<char>(codePoint));
+            }
+            else if (codePoint < 0x800) {
+                result.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+                result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else if (codePoint < 0x10000) {
+                result.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+                result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else {
+                result.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+                result.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+                result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+        }
+
+        uint32_t ParseHex4() {
+            if (position_ + 4 > text_.size()) Fail("4 hex digits");
+            uint32_t result = 0;
+            for (int i = 0; i < 4; ++i) {
+                char c = text_[position_++];
+                result <<= 4;
+                if (c >= '0' && c <= '9') result |= c - '0';
+                else if (c >= 'a' && c <= 'f') result |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') result |= c - 'A' + 10;
+                else Fail("a hex digit");
+            }
+            return result;
+        }
+
+        std::string ParseString() {
+            if (!Consume('"')) Fail("a string");
+            std::string result;
+            while (true) {
+                if (position_ >= text_.size()) Fail("'\"'");
+                char c = text_[position_++];
+                if (c == '"') return result;
+                if (c != '\\') {
+                    result.push_back(c);
+                    continue;
+                }
+                if (position_ >= text_.size()) Fail("an escape");
+                switch (char escaped = text_[position_++]) {
+                case '"': case '\\': case '/': result.push_back(escaped); break;
+                case 'b': result.push_back('\b'); break;
+                case 'f': result.push_back('\f'); break;
+                case 'n': result.push_back('\n'); break;
+                case 'r': result.push_back('\r'); break;
+                case 't': result.push_back('\t'); break;
+                case 'u': {
+                    uint32_t codePoint = ParseHex4();
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00 && ConsumeWord("\\u")) {
+                        uint32_t low = ParseHex4();
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    AppendUTF8(result, codePoint);
+                    break;
+                }
+                default: Fail("an escape");
+                }
+            }
+        }
+
+        JSONValue ParseValue() {
+            SkipSpaces();
+            if (position_ >= text_.size()) Fail("a value");
+
+            char c = text_[position_];
+            if (c == '"') {
+                return JSONValue { ParseString() };
+            }
+            if (Consume('[')) {
+                JSONValue::Array array;
+                if (Consume(']')) return JSONValue { std::move(array) };
+                do {
+                    array.push_back(ParseValue());
+                } while (Consume(','));
+                if (!Consume(']')) Fail("']'");
+                return JSONValue { std::move(array) };
+            }
+            if (Consume('{')) {
+                JSONValue::Object object;
+                if (Consume('}')) return JSONValue { std::move(object) };
+                do {
+                    SkipSpaces();
+                    std::string key = ParseString();
+                    if (!Consume(':')) Fail("':'");
+                    object.emplace_back(std::move(key), ParseValue());
+                } while (Consume(','));
+                if (!Consume('}')) Fail("'}'");
+                return JSONValue { std::move(object) };
+            }
+            if (ConsumeWord("true")) return JSONValue { true };
+            if (ConsumeWord("false")) return JSONValue { false };
+            if (ConsumeWord("null")) return JSONValue { nullptr };
+
+            const char* start = text_.c_str() + position_;
+            char* end;
+            double number = std::strtod(start, &end);
+            if (end == start) Fail("a value");
+            position_ += end - start;
+            return JSONValue { number };
+        }
+    public:
+        explicit JSONParser(const std::string& text): text_(text) { }
+
+        JSONValue Parse() {
+            JSONValue value = ParseValue();
+            SkipSpaces();
+            if (position_ != text_.size()) Fail("the end");
+            return value;
+        }
+    };
+
+    std::optional<std::string> GetEnv(const char* name) {
+        const char* value = std::getenv(name);
+        if (value == nullptr || *value == '\0') return std::nullopt;
+        return std::string(value);
+    }
+
+    std::vector<std::string> SplitBySpaces(const std::string& string) {
+        std::istringstream stream(string);
+        return std::vector<std::string>(std::istream_iterator<std::string>(stream), std::istream_iterator<std::string>());
+    }
+
+    // Mirrors internal/app-path.ts: the default app may run the app in DESKGAP_ENTRY instead.
+    fs::path AppPath(const std::string& resourcePath) {
+        fs::path appPath = fs::u8path(resourcePath) / "app";
+        if (std::optional<std::string> entry = GetEnv("DESKGAP_ENTRY"); entry.has_value()) {
+            std::error_code error;
+            if (fs::exists(appPath / "DESKGAP_DEFAULT_APP", error)) {
+                fs::path entryPath = fs::u8path(*entry);
+                return fs::is_directory(entryPath, error) ? entryPath : entryPath.parent_path();
+            }
+        }
+        return appPath;
+    }
+
+    int ToPositiveInt(double number) {
+        if (!(number >= 1 && number <= 1024) || std::floor(number) != number) {
+            throw std::runtime_error("Expected an integer between 1 and 1024");
+        }
+        return static_cast<int>(number);
+    }
+
+    std::optional<int> ToPositiveInt(const JSONValue* value) {
+        if (value == nullptr) return std::nullopt;
+        const double* number = std::get_if<double>(&value->value);
+        if (number == nullptr) {
+            throw std::runtime_error("Expected an integer between 1 and 1024");
+        }
+        return ToPositiveInt(*number);
+    }
+
+    int ToPositiveInt(const std::string& string) {
+        const char* start = string.c_str();
+        char* end;
+        double number = std::strtod(start, &end);
+        if (end == start || *end != '\0') {
+            throw std::runtime_error("Expected an integer between 1 and 1024");
+        }
+        return ToPositiveInt(number);
+    }
+
+    std::vector<std::string> ToStrings(const JSONValue* value) {
+        if (value == nullptr) return { };
+        if (const std::string* string = std::get_if<std::string>(&value->value)) {
+            return SplitBySpaces(*string);
+        }
+        const JSONValue::Array* array = std::get_if<JSONValue::Array>(&value->value);
+        if (array == nullptr) {
+            throw std::runtime_error("Expected an array of strings");
+        }
+        std::vector<std::string> strings;
+        for (const JSONValue& element: *array) {
+            const std::string* string = std::get_if<std::string>(&element.value);
+            if (string == nullptr) {
+                throw std::runtime_error("Expected an array of strings");
+            }
+            strings.push_back(*string);
+        }
+        return strings;
+    }
+}
+
+DeskGap::NodeOptions DeskGap::NodeOptions::Load(const std::string& resourcePath, std::vector<std::string>& errors) {
+    NodeOptions options;
+
+    fs::path packageJSONPath = AppPath(resourcePath) / "package.json";
+    if (std::ifstream file(packageJSONPath, std::ios::binary); file) {
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        const auto readField = [&](const JSONValue& field, const char* name, auto&& apply) {
+            try {
+                apply(field.Find(name));
+            }
+            catch (const std::exception& e) {
+                errors.push_back(packageJSONPath.u8string() + ": deskgap." + name + ": " + e.what());
+            }
+        };
+        try {
+            JSONValue packageJSON = JSONParser(text).Parse();
+            if (const JSONValue* field = packageJSON.Find("deskgap")) {
+                readField(*field, "platformWorkerThreads", [&](const JSONValue* value) {
+                    options.platformWorkerThreads = ToPositiveInt(value).value_or(options.platformWorkerThreads);
+                });
+                readField(*field, "uvThreadpoolSize", [&](const JSONValue* value) {
+                    options.uvThreadpoolSize = ToPositiveInt(value);
+                });
+                readField(*field, "v8Flags", [&](const JSONValue* value) {
+                    options.v8Flags = ToStrings(value);
+                });
+                readField(*field, "execArgv", [&](const JSONValue* value) {
+                    options.execArgv = ToStrings(value);
+                });
+            }
+        }
+        catch (const std::exception& e) {
+            errors.push_back(packageJSONPath.u8string() + ": " + e.what());
+        }
+    }
+
+    if (std::optional<std::string> threads = GetEnv("DESKGAP_PLATFORM_WORKER_THREADS"); threads.has_value()) {
+        try {
+            options.platformWorkerThreads = ToPositiveInt(*threads);
+        }
+        catch (const std::exception& e) {
+            errors.push_back(std::string("DESKGAP_PLATFORM_WORKER_THREADS: ") + e.what());
+        }
+    }
+    if (GetEnv("UV_THREADPOOL_SIZE").has_value()) {
+        // libuv reads it by itself
+        options.uvThreadpoolSize.reset();
+    }
+    if (std::optional<std::string> v8Flags = GetEnv("DESKGAP_V8_FLAGS"); v8Flags.has_value()) {
+        options.v8Flags = SplitBySpaces(*v8Flags);
+    }
+    if (std::optional<std::string> execArgv = GetEnv("DESKGAP_EXEC_ARGV"); execArgv.has_value()) {
+        options.execArgv = SplitBySpaces(*execArgv);
+    }
+    return options;
+}
+
+std::vector<std::string> DeskGap::NodeOptions::CommandLineOptions() const {
+    return execArgv;
+}
+
+void DeskGap::NodeOptions::ApplyToEnvironment() const {
+    if (!uvThreadpoolSize.has_value()) return;
+    std::string size = std::to_string(*uvThreadpoolSize);
+#ifdef WIN32
+    _putenv_s("UV_THREADPOOL_SIZE", size.c_str());
+#else
+    setenv("UV_THREADPOOL_SIZE", size.c_str(), 1);
+#endif
+}
@@ -0,0 +1,38 @@
+#ifndef DESKGAP_NODE_OPTIONS_HPP
+#define DESKGAP_NODE_OPTIONS_HPP
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace DeskGap {
+    // How the embedded Node is set up, read before the V8 platform and the isolate are created.
+    // The "deskgap" field of the package.json of the app:
+    //     "deskgap": {
+    //         "platformWorkerThreads": 8,
+    //         "uvThreadpoolSize": 16,
+    //         "v8Flags": ["--max-old-space-size=4096", "--max-semi-space-size=64"],
+    //         "execArgv": ["--expose-gc"]
+    //     }
+    // is overridden by the environment variables DESKGAP_PLATFORM_WORKER_THREADS, UV_THREADPOOL_SIZE,
+    // DESKGAP_V8_FLAGS and DESKGAP_EXEC_ARGV (the last two are space-separated).
+    struct NodeOptions {
+        int platformWorkerThreads = 4;
+        std::optional<int> uvThreadpoolSize;
+        std::vector<std::string> v8Flags;
+        std::vector<std::string> execArgv;
+
+        // Errors in the package.json and the environment variables are appended to `errors`,
+        // and the defaults are kept for the bad fields.
+        static NodeOptions Load(const std::string& resourcePath, std::vector<std::string>& errors);
+
+        // The options to be parsed by node::InitializeNodeWithArgs, after argv[0].
+        // The V8 flags are not included: they are set by the embedder, which reports and ignores the ones V8 does not know,
+        // while Node would fail to start.
+        std::vector<std::string> CommandLineOptions() const;
+        // Sets UV_THREADPOOL_SIZE, which libuv reads when its thread pool is first used
+        void ApplyToEnvironment() const;
+    };
+}
+
+#endif
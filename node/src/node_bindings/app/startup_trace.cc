@@ -0,0 +1,28 @@
+#include <chrono>
+#include <mutex>
+#include <utility>
+#include "startup_trace.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point startTime;
+    std::mutex eventsMutex;
+    std::vector<DeskGap::StartupTrace::Event> events;
+}
+
+void DeskGap::StartupTrace::Start() {
+    startTime = Clock::now();
+    Record("main", Phase::INSTANT, Thread::UI);
+}
+
+void DeskGap::StartupTrace::Record(std::string name, Phase phase, Thread thread) {
+    int64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - startTime).count();
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    events.push_back(Event { std::move(name), phase, thread, timestamp });
+}
+
+std::vector<DeskGap::StartupTrace::Event> DeskGap::StartupTrace::Events() {
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    return events;
+}
@@ -0,0 +1,37 @@
+#ifndef DESKGAP_STARTUP_TRACE_HPP
+#define DESKGAP_STARTUP_TRACE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DeskGap {
+    // Records the phases from main() to the first shown window, on both the UI thread and the node thread.
+    // The phases use the same letters as the "ph" field of the Chrome trace event format.
+    class StartupTrace {
+    public:
+        enum class Phase: char {
+            BEGIN = 'B',
+            END = 'E',
+            INSTANT = 'I'
+        };
+        enum class Thread: int {
+            UI = 1,
+            NODE = 2
+        };
+        struct Event {
+            std::string name;
+            Phase phase;
+            Thread thread;
+            // Microseconds since main() was entered
+            int64_t timestamp;
+        };
+
+        // Called first thing in main(), so the timestamps of all events are relative to it.
+        static void Start();
+        static void Record(std::string name, Phase phase, Thread thread);
+        static std::vector<Event> Events();
+    };
+}
+
+#endif
@@ -13,58 +13,40 @@ namespace DeskGap::JSNativeConvertion {
     using FileFilter = CommonFileDialogOptions::FileFilter;
 
     template<>
-    struct Native<FileFilter> {
-        inline static FileFilter From(const Napi::Value& jsValue) {
-            Napi::Object jsObject = jsValue.As<Napi::Object>();
-            FileFilter result;
-            ToNative(result.name, jsObject.Get("name"));
-            ToNative(result.extensions, jsObject.Get("extensions"));
-            return result;
-        }
+    struct Reflection<FileFilter> {
+        static constexpr auto fields = std::make_tuple(
+            Field("name", &FileFilter::name),
+            Field("extensions", &FileFilter::extensions)
+        );
     };
 
     template<>
-    struct Native<CommonFileDialogOptions> {
-        inline static CommonFileDialogOptions From(const Napi::Value& jsValue) {
-            Napi::Object jsOptions = jsValue.As<Napi::Object>();
-            CommonFileDialogOptions options;
-
-            ToNative(options.title, jsOptions.Get("title"));
-            ToNative(options.defaultDirectory, jsOptions.Get("defaultDirectory"));
-            ToNative(options.defaultFilename, jsOptions.Get("defaultFilename"));
-            ToNative(options.buttonLabel, jsOptions.Get("buttonLabel"));
-            ToNative(options.filters, jsOptions.Get("filters"));
-            ToNative(options.message, jsOptions.Get("message"));
-
-            return options;
-        }
+    struct Reflection<CommonFileDialogOptions> {
+        static constexpr auto fields = std::make_tuple(
+            Field("title", &CommonFileDialogOptions::title),
+            Field("defaultDirectory", &CommonFileDialogOptions::defaultDirectory),
+            Field("defaultFilename", &CommonFileDialogOptions::defaultFilename),
+            Field("buttonLabel", &CommonFileDialogOptions::buttonLabel),
+            Field("filters", &CommonFileDialogOptions::filters),
+            Field("message", &CommonFileDialogOptions::message)
+        );
     };
 
     template<>
-    struct Native<OpenDialogOptions> {
-        inline static OpenDialogOptions From(const Napi::Value& jsValue) {
-            Napi::Object jsOptions = jsValue.As<Napi::Object>();
-            
-            OpenDialogOptions options;
-            ToNative(options.commonOptions, jsOptions.Get("commonOptions"));
-            ToNative(options.properties, jsOptions.Get("propertyBits"));
-
-            return options;
-        }
+    struct Reflection<OpenDialogOptions> {
+        static constexpr auto fields = std::make_tuple(
+            Field("commonOptions", &OpenDialogOptions::commonOptions),
+            Field("propertyBits", &OpenDialogOptions::properties)
+        );
     };
 
     template<>
-    struct Native<SaveDialogOptions> {
-        inline static SaveDialogOptions From(const Napi::Value& jsValue) {
-            Napi::Object jsOptions = jsValue.As<Napi::Object>();
-            
-            SaveDialogOptions options;
-            ToNative(options.commonOptions, jsOptions.Get("commonOptions"));
-            ToNative(options.nameFieldLabel, jsOptions.Get("nameFieldLabel"));
-            ToNative(options.showsTagField, jsOptions.Get("showsTagField"));
-
-            return options;
-        }
+    struct Reflection<SaveDialogOptions> {
+        static constexpr auto fields = std::make_tuple(
+            Field("commonOptions", &SaveDialogOptions::commonOptions),
+            Field("nameFieldLabel", &SaveDialogOptions::nameFieldLabel),
+            Field("showsTagField", &SaveDialogOptions::showsTagField)
+        );
     };
 }
 
@@ -0,0 +1,157 @@
+#ifndef action_arena_h
+#define action_arena_h
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace DeskGap {
+    // A FIFO of void() callables stored in place in reusable blocks, so queuing an action does not allocate
+    // once the blocks have grown to the size of a typical transaction. The actions never move after being queued.
+    class ActionArena {
+    private:
+        struct Entry {
+            // Runs the action and destroys it, even if it throws
+            void (*runAndDestroy)(Entry*);
+            void (*destroy)(Entry*);
+            Entry* next;
+        };
+        struct Block {
+            std::unique_ptr<std::byte[]> bytes;
+            size_t size;
+        };
+
+        static constexpr size_t kBlockSize = 16 * 1024;
+
+        std::vector<Block> blocks_;
+        size_t blockIndex_ = 0;
+        size_t blockOffset_ = 0;
+        Entry* head_ = nullptr;
+        Entry* tail_ = nullptr;
+
+        template <class F>
+        static constexpr size_t StorageOffset() {
+            return (sizeof(Entry) + alignof(F) - 1) / alignof(F) * alignof(F);
+        }
+        template <class F>
+        static F* StorageOf(Entry* entry) {
+            return std::launder(reinterpret_cast<F*>(reinterpret_cast<std::byte*>(entry) + StorageOffset<F>()));
+        }
+
+        // The blocks are kept for the next transaction
+        void Rewind() {
+            blockIndex_ = 0;
+            blockOffset_ = 0;
+        }
+
+        void* Allocate(size_t size) {
+            constexpr size_t alignment = alignof(std::max_align_t);
+            size = (size + alignment - 1) / alignment * alignment;
+            while (true) {
+                if (blockIndex_ < blocks_.size()) {
+                    Block& block = blocks_[blockIndex_];
+                    if (block.size - blockOffset_ >= size) {
+                        void* result = block.bytes.get() + blockOffset_;
+                        blockOffset_ += size;
+                        return result;
+                    }
+                    // A block holding entries is never reused before a rewind, so the search moves past it
+                    if (blockOffset_ > 0) {
+                        ++blockIndex_;
+                        blockOffset_ = 0;
+                        continue;
+                    }
+                }
+                // The blocks from blockIndex_ on hold no entries, so a block is inserted before the ones too small
+                size_t blockSize = size > kBlockSize ? size : kBlockSize;
+                blocks_.insert(blocks_.begin() + blockIndex_, Block { std::make_unique<std::byte[]>(blockSize), blockSize });
+            }
+        }
+    public:
+        ActionArena() = default;
+        ActionArena(const ActionArena&) = delete;
+        ActionArena& operator=(const ActionArena&) = delete;
+        ~ActionArena() {
+            Clear();
+        }
+
+        template <class Action>
+        void Emplace(Action&& action) {
+            using F = std::decay_t<Action>;
+            static_assert(alignof(F) <= alignof(std::max_align_t), "Over-aligned actions are not supported");
+
+            auto entry = static_cast<Entry*>(Allocate(StorageOffset<F>() + sizeof(F)));
+            new (StorageOf<F>(entry)) F(std::forward<Action>(action));
+            new (entry) Entry {
+                [](Entry* entry) {
+                    struct Destroyer {
+                        F* action;
+                        ~Destroyer() { action->~F(); }
+                    } destroyer { StorageOf<F>(entry) };
+                    (*destroyer.action)();
+                },
+                [](Entry* entry) {
+                    StorageOf<F>(entry)->~F();
+                },
+                nullptr
+            };
+            if (tail_ == nullptr) {
+                head_ = entry;
+            }
+            else {
+                tail_->next = entry;
+            }
+            tail_ = entry;
+        }
+
+        bool Empty() const {
+            return head_ == nullptr;
+        }
+
+        void Swap(ActionArena& other) noexcept {
+            std::swap(blocks_, other.blocks_);
+            std::swap(blockIndex_, other.blockIndex_);
+            std::swap(blockOffset_, other.blockOffset_);
+            std::swap(head_, other.head_);
+            std::swap(tail_, other.tail_);
+        }
+
+        // Runs the actions in order until all of them have run or `shouldYield` returns true after one of them.
+        // An action that throws is still removed, and the exception propagates with the rest left queued.
+        // The blocks are rewound once the queue is empty, even if its last action throws.
+        template <class ShouldYield>
+        void RunUntil(ShouldYield&& shouldYield) {
+            struct Rewinder {
+                ActionArena* arena;
+                ~Rewinder() {
+                    if (arena->head_ == nullptr) arena->Rewind();
+                }
+            } rewinder { this };
+            while (head_ != nullptr) {
+                Entry* entry = head_;
+                head_ = entry->next;
+                if (head_ == nullptr) {
+                    tail_ = nullptr;
+                }
+                entry->runAndDestroy(entry);
+                if (shouldYield()) return;
+            }
+        }
+
+        // Destroys the queued actions without running them
+        void Clear() {
+            while (head_ != nullptr) {
+                Entry* entry = head_;
+                head_ = entry->next;
+                entry->destroy(entry);
+            }
+            tail_ = nullptr;
+            Rewind();
+        }
+    };
+}
+
+#endif /* action_arena_h */
@@ -1,2 +1,3 @@
 #include "node_dispatch.h"
 #include "ui_dispatch.h"
+#include "event_channel.h"
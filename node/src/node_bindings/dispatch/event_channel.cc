@@ -0,0 +1,239 @@
+#include <cassert>
+#include <memory>
+#include <vector>
+#include <napi.h>
+#include "event_channel.h"
+#include "../env_data.h"
+
+namespace DeskGap {
+    std::shared_ptr<EventChannel> EventChannel::Create(napi_env env) {
+        std::shared_ptr<EventChannel> channel(new EventChannel(env));
+
+        // Keeps the channel alive until the thread-safe function is finalized
+        auto finalizeData = new std::shared_ptr<EventChannel>(channel);
+        napi_status status = napi_create_threadsafe_function(
+            env, /*func*/nullptr,
+            /*async_resource*/nullptr, /*async_resource_name*/Napi::String::New(env, "EventChannel"),
+            /*max_queue_size*/0, /*initial_thread_count*/1,
+            /*thread_finalize_data*/finalizeData, /*thread_finalize_cb*/EventChannel::Finalize,
+            /*context*/channel.get(), /*call_js_cb*/EventChannel::CallJS,
+            &channel->function_
+        );
+        assert(status == napi_ok);
+
+        // Referenced again when a target is added
+        status = napi_unref_threadsafe_function(env, channel->function_);
+        assert(status == napi_ok);
+        return channel;
+    }
+
+    EventChannel::~EventChannel() {
+        // No other thread holds the channel any more
+        Event event;
+        while (Pop(event)) {
+            delete event.payload;
+        }
+    }
+
+    uint32_t EventChannel::AddTarget(std::vector<Napi::Function>&& handlers, bool keepsEventLoopAlive) {
+        std::vector<Napi::FunctionReference> handlerReferences;
+        handlerReferences.reserve(handlers.size());
+        for (const Napi::Function& handler: handlers) {
+            handlerReferences.push_back(Napi::Persistent(handler));
+        }
+
+        uint32_t targetId = ++lastTargetId_;
+        targets_.emplace(targetId, Target { std::move(handlerReferences), keepsEventLoopAlive });
+        if (keepsEventLoopAlive && ++eventLoopKeepingTargetCount_ == 1) {
+            std::lock_guard<std::mutex> lock(functionMutex_);
+            if (function_ != nullptr && !isClosed_) {
+                napi_status status = napi_ref_threadsafe_function(env_, function_);
+                assert(status == napi_ok);
+            }
+        }
+        return targetId;
+    }
+
+    void EventChannel::RemoveTarget(uint32_t targetId) {
+        auto target = targets_.find(targetId);
+        if (target == targets_.end()) {
+            return;
+        }
+        bool keepsEventLoopAlive = target->second.keepsEventLoopAlive;
+        targets_.erase(target);
+        if (!keepsEventLoopAlive || --eventLoopKeepingTargetCount_ > 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(functionMutex_);
+        if (function_ != nullptr && !isClosed_) {
+            napi_status status = napi_unref_threadsafe_function(env_, function_);
+            assert(status == napi_ok);
+        }
+    }
+
+    void EventChannel::Send(uint32_t targetId, uint32_t type) {
+        Push({ targetId, type });
+    }
+    void EventChannel::Send(uint32_t targetId, uint32_t type, double number) {
+        Push({ targetId, type, number, true });
+    }
+    void EventChannel::Send(uint32_t targetId, uint32_t type, std::unique_ptr<EventPayload>&& payload) {
+        Push({ targetId, type, 0, false, payload.release() });
+    }
+
+    void EventChannel::Push(Event&& event) {
+        bool isPushed = false;
+        if (!isOverflowing_.load(std::memory_order_acquire)) {
+            isPushed = ring_.TryPush(event);
+        }
+        if (!isPushed) {
+            // The UI thread never waits for the Node thread to make room
+            std::lock_guard<std::mutex> lock(overflowMutex_);
+            isOverflowing_.store(true, std::memory_order_release);
+            overflow_.push_back(event);
+        }
+        ScheduleWake();
+    }
+
+    bool EventChannel::Pop(Event& event) {
+        if (!draining_.empty()) {
+            event = draining_.front();
+            draining_.pop_front();
+            return true;
+        }
+        if (ring_.TryPop(event)) {
+            return true;
+        }
+        if (!isOverflowing_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        {
+            // The events pushed to the ring from now on follow the overflowed ones, which are drained first
+            std::lock_guard<std::mutex> lock(overflowMutex_);
+            draining_.assign(overflow_.begin(), overflow_.end());
+            overflow_.clear();
+            isOverflowing_.store(false, std::memory_order_release);
+        }
+        if (draining_.empty()) {
+            return false;
+        }
+        event = draining_.front();
+        draining_.pop_front();
+        return true;
+    }
+
+    void EventChannel::ScheduleWake() {
+        // Pairs with the fence in Drain: either the drain sees the event that was just pushed,
+        // or this sees the flag it cleared and wakes the Node thread again
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (isWakeScheduled_.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(functionMutex_);
+        if (function_ != nullptr && !isClosed_) {
+            napi_call_threadsafe_function(function_, nullptr, napi_tsfn_nonblocking);
+        }
+    }
+
+    void EventChannel::Drain() {
+        // The events sent from now on schedule another wake, even if this drain delivers them.
+        // The fence keeps the loads of the ring below from being reordered before the flag is cleared.
+        isWakeScheduled_.exchange(false, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        Event event;
+        for (size_t i = 0; i < kMaxEventsPerDrain; ++i) {
+            if (!Pop(event)) {
+                return;
+            }
+            Deliver(event);
+        }
+        // Let the event loop run before delivering the rest
+        ScheduleWake();
+    }
+
+    void EventChannel::Deliver(Event& event) {
+        std::unique_ptr<EventPayload> payload(event.payload);
+
+        auto target = targets_.find(event.targetId);
+        if (target == targets_.end() || event.type >= target->second.handlers.size() || target->second.handlers[event.type].IsEmpty()) {
+            return;
+        }
+
+        Napi::HandleScope scope(env_);
+        // The handler may remove its target
+        Napi::Function handler = target->second.handlers[event.type].Value();
+        try {
+            std::vector<napi_value> args;
+            if (payload != nullptr) {
+                args.push_back(payload->ToJS(env_));
+            }
+            else if (event.hasNumber) {
+                args.push_back(Napi::Number::New(env_, event.number));
+            }
+            handler.Call(args);
+        }
+        catch (const Napi::Error& e) {
+            napi_fatal_exception(e.Env(), e.Value());
+        }
+    }
+
+    void EventChannel::CallJS(napi_env env, napi_value jsCallback, void* context, void* data) {
+        if (env == nullptr) {
+            return;
+        }
+        static_cast<EventChannel*>(context)->Drain();
+    }
+
+    void EventChannel::Finalize(napi_env env, void* finalizeData, void* finalizeHint) {
+        auto channel = static_cast<std::shared_ptr<EventChannel>*>(finalizeData);
+        {
+            std::lock_guard<std::mutex> lock((*channel)->functionMutex_);
+            (*channel)->function_ = nullptr;
+            (*channel)->isClosed_ = true;
+        }
+        // The references are deleted while the env is still alive
+        (*channel)->targets_.clear();
+        delete channel;
+    }
+
+    void EventChannel::Close() {
+        std::lock_guard<std::mutex> lock(functionMutex_);
+        if (function_ != nullptr && !isClosed_) {
+            isClosed_ = true;
+            napi_status status = napi_release_threadsafe_function(function_, napi_tsfn_abort);
+            assert(status == napi_ok);
+        }
+    }
+
+    EventTarget::EventTarget(napi_env env, std::vector<Napi::Function>&& handlers, bool keepsEventLoopAlive):
+        channel_(EnvData::Of(env).eventChannel),
+        id_(channel_->AddTarget(std::move(handlers), keepsEventLoopAlive)) { }
+
+    EventTarget::EventTarget(EventTarget&& other) noexcept:
+        channel_(std::move(other.channel_)), id_(other.id_), isRemoved_(other.isRemoved_) {
+        other.isRemoved_ = true;
+    }
+
+    EventTarget& EventTarget::operator=(EventTarget&& other) noexcept {
+        if (this != &other) {
+            Remove();
+            channel_ = std::move(other.channel_);
+            id_ = other.id_;
+            isRemoved_ = other.isRemoved_;
+            other.isRemoved_ = true;
+        }
+        return *this;
+    }
+
+    EventTarget::~EventTarget() {
+        Remove();
+    }
+
+    void EventTarget::Remove() {
+        if (channel_ != nullptr && !isRemoved_) {
+            channel_->RemoveTarget(id_);
+        }
+        isRemoved_ = true;
+    }
+}
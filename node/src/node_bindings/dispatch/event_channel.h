@@ -0,0 +1,163 @@
+#ifndef event_channel_h
+#define event_channel_h
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <napi.h>
+#include <node_api.h>
+#include "event_ring.h"
+
+namespace DeskGap {
+    // The value of an event that is more than a number, converted on the Node thread when the event is delivered
+    class EventPayload {
+    public:
+        virtual ~EventPayload() = default;
+        virtual napi_value ToJS(napi_env env) = 0;
+    };
+
+    // A payload converted by a function object, like the JSArgsGetter of JSFunctionForUI::Call
+    template <class Convert>
+    class ConvertedEventPayload: public EventPayload {
+    private:
+        Convert convert_;
+    public:
+        explicit ConvertedEventPayload(Convert&& convert): convert_(std::move(convert)) { }
+        napi_value ToJS(napi_env env) override {
+            return convert_(env);
+        }
+    };
+
+    template <class Convert>
+    std::unique_ptr<EventPayload> MakeEventPayload(Convert&& convert) {
+        return std::make_unique<ConvertedEventPayload<std::decay_t<Convert>>>(std::forward<Convert>(convert));
+    }
+
+    // Delivers the events of all the native objects of an env to their JS handlers through one thread-safe function.
+    // An event is a few words pushed to a lock-free ring on the UI thread, and only the first event after a drain wakes the Node thread,
+    // so a burst of events costs one wake instead of one allocation and one wake each.
+    // The events sent by one thread are delivered in order, and so are the sends on different threads that do not overlap.
+    // Sends that overlap may be delivered in either order: one that checked isOverflowing_ before another send overflowed
+    // can land in the ring ahead of the overflowed events.
+    class EventChannel {
+    private:
+        struct Event {
+            uint32_t targetId = 0;
+            uint32_t type = 0;
+            double number = 0;
+            bool hasNumber = false;
+            // Owned by the event
+            EventPayload* payload = nullptr;
+        };
+        static constexpr size_t kRingCapacity = 4096;
+        // Events delivered in one callback of the thread-safe function before yielding to the event loop
+        static constexpr size_t kMaxEventsPerDrain = 1024;
+
+        EventRing<Event> ring_ { kRingCapacity };
+
+        // The events that arrive while the ring is full, kept in order behind the ones in the ring.
+        // They are only taken by the drain once the ring is empty, and new events follow them here until then.
+        std::mutex overflowMutex_;
+        std::vector<Event> overflow_;
+        std::atomic<bool> isOverflowing_ { false };
+
+        // Set by the first event after a drain started
+        std::atomic<bool> isWakeScheduled_ { false };
+
+        // Guards the thread-safe function against being called after it is released or finalized
+        std::mutex functionMutex_;
+        napi_threadsafe_function function_ = nullptr;
+        bool isClosed_ = false;
+
+        // Used by the Node thread only
+        napi_env env_;
+        std::deque<Event> draining_;
+        uint32_t lastTargetId_ = 0;
+        struct Target {
+            std::vector<Napi::FunctionReference> handlers;
+            bool keepsEventLoopAlive;
+        };
+        std::unordered_map<uint32_t, Target> targets_;
+        size_t eventLoopKeepingTargetCount_ = 0;
+
+        explicit EventChannel(napi_env env): env_(env) { }
+
+        void Push(Event&& event);
+        bool Pop(Event& event);
+        void ScheduleWake();
+        void Drain();
+        void Deliver(Event& event);
+        static void CallJS(napi_env env, napi_value jsCallback, void* context, void* data);
+        static void Finalize(napi_env env, void* finalizeData, void* finalizeHint);
+    public:
+        EventChannel(const EventChannel&) = delete;
+        EventChannel& operator=(const EventChannel&) = delete;
+        ~EventChannel();
+
+        static std::shared_ptr<EventChannel> Create(napi_env env);
+
+        // Called on the Node thread. The handlers are indexed by the types of the events.
+        // Unless told otherwise, the event loop is kept alive while there are targets, as the thread-safe function of each callback did.
+        uint32_t AddTarget(std::vector<Napi::Function>&& handlers, bool keepsEventLoopAlive = true);
+        void RemoveTarget(uint32_t targetId);
+
+        // Called on any thread. The events of a target that has been removed are dropped.
+        void Send(uint32_t targetId, uint32_t type);
+        void Send(uint32_t targetId, uint32_t type, double number);
+        void Send(uint32_t targetId, uint32_t type, std::unique_ptr<EventPayload>&& payload);
+
+        // Called when the env is torn down. The events that are not delivered yet are dropped.
+        void Close();
+    };
+
+    // Sends one type of events of a target, captured by the callbacks of the native objects on the UI thread
+    class EventSender {
+    private:
+        std::shared_ptr<EventChannel> channel_;
+        uint32_t targetId_;
+        uint32_t type_;
+    public:
+        EventSender(std::shared_ptr<EventChannel> channel, uint32_t targetId, uint32_t type):
+            channel_(std::move(channel)), targetId_(targetId), type_(type) { }
+
+        void operator()() const {
+            channel_->Send(targetId_, type_);
+        }
+        void operator()(double number) const {
+            channel_->Send(targetId_, type_, number);
+        }
+        void operator()(std::unique_ptr<EventPayload>&& payload) const {
+            channel_->Send(targetId_, type_, std::move(payload));
+        }
+    };
+
+    // The handlers of a wrap in the event channel of its env, removed when Remove is called or the wrap is finalized.
+    // Only Remove changes it after it is assigned, so the UI thread may still make senders of it, whose events are then dropped.
+    class EventTarget {
+    private:
+        std::shared_ptr<EventChannel> channel_;
+        uint32_t id_ = 0;
+        bool isRemoved_ = false;
+    public:
+        EventTarget() = default;
+        EventTarget(napi_env env, std::vector<Napi::Function>&& handlers, bool keepsEventLoopAlive = true);
+        EventTarget(EventTarget&& other) noexcept;
+        EventTarget& operator=(EventTarget&& other) noexcept;
+        ~EventTarget();
+
+        template <class Type>
+        EventSender Sender(Type type) const {
+            return EventSender(channel_, id_, static_cast<uint32_t>(type));
+        }
+
+        void Remove();
+    };
+}
+
+#endif /* event_channel_h */
@@ -0,0 +1,73 @@
+#ifndef event_ring_h
+#define event_ring_h
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace DeskGap {
+    // A bounded lock-free ring for any number of producers and one consumer.
+    // Every slot carries a sequence number that tells whether it is free for the producer
+    // of the current lap or filled for the consumer, so neither side takes a lock.
+    template <class T>
+    class EventRing {
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Slot[]> slots_;
+        size_t mask_;
+        alignas(64) std::atomic<size_t> enqueuePosition_ { 0 };
+        // Only used by the consumer
+        alignas(64) size_t dequeuePosition_ = 0;
+    public:
+        // The capacity must be a power of two
+        explicit EventRing(size_t capacity): slots_(std::make_unique<Slot[]>(capacity)), mask_(capacity - 1) {
+            for (size_t i = 0; i < capacity; ++i) {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+        EventRing(const EventRing&) = delete;
+        EventRing& operator=(const EventRing&) = delete;
+
+        // Returns false if the ring is full, and leaves the value untouched
+        bool TryPush(T& value) {
+            size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& slot = slots_[position & mask_];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                auto lap = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+                if (lap == 0) {
+                    if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        slot.value = std::move(value);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (lap < 0) {
+                    return false;
+                }
+                else {
+                    position = enqueuePosition_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Called by the consumer only
+        bool TryPop(T& value) {
+            Slot& slot = slots_[dequeuePosition_ & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition_ + 1) {
+                return false;
+            }
+            value = std::move(slot.value);
+            slot.sequence.store(dequeuePosition_ + mask_ + 1, std::memory_order_release);
+            ++dequeuePosition_;
+            return true;
+        }
+    };
+}
+
+#endif /* event_ring_h */
@@ -10,33 +10,49 @@ namespace DeskGap {
             napi_threadsafe_function holdedThreadSafeFunction;
         };
     }
-    JSFunctionForUI::JSFunctionForUI(const Napi::Function& js_func, bool holdWhileQueuing): holdWhileQueuing_(holdWhileQueuing) {
+    JSFunctionForUI::JSFunctionForUI(const Napi::Function& js_func, bool holdWhileQueuing):
+        holdWhileQueuing_(holdWhileQueuing), state_(std::make_shared<State>()) {
         napi_status status = napi_create_threadsafe_function(
             js_func.Env(), js_func,
             /*async_resource*/nullptr, /*async_resource_name*/Napi::String::New(js_func.Env(), "JSFunctionForUI"),
             /*max_queue_size*/0, /*initial_thread_count*/1, 
-            /*thread_finalize_data*/nullptr, /*thread_finalize_cb*/nullptr,
+            /*thread_finalize_data*/new std::shared_ptr<State>(state_), /*thread_finalize_cb*/JSFunctionForUI::finalize_cb,
             /*context*/this, /*call_js_cb*/JSFunctionForUI::call_js_cb,
-            &threadsafe_function_
+            &state_->threadsafeFunction
         );
         assert(status == napi_ok);
     }
 
     void JSFunctionForUI::Call_(std::optional<JSArgsGetter>&& getArgs) {
-        napi_status status;
         auto data = new ThreadSafeFunctionData { std::move(getArgs), nullptr };
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        napi_threadsafe_function threadsafeFunction = state_->threadsafeFunction;
+        if (threadsafeFunction == nullptr) {
+            delete data;
+            return;
+        }
+        napi_status status;
         if (holdWhileQueuing_) {
-            status = napi_acquire_threadsafe_function(threadsafe_function_);
-            assert(status == napi_ok);
-
-            data->holdedThreadSafeFunction = threadsafe_function_;
+            status = napi_acquire_threadsafe_function(threadsafeFunction);
+            if (status != napi_ok) {
+                // napi_closing: the env is being torn down
+                delete data;
+                return;
+            }
+            data->holdedThreadSafeFunction = threadsafeFunction;
         }
         status = napi_call_threadsafe_function(
-            threadsafe_function_,
+            threadsafeFunction,
             data,
             napi_tsfn_blocking
         );
-        assert(status == napi_ok);
+        if (status != napi_ok) {
+            assert(status == napi_closing);
+            if (data->holdedThreadSafeFunction != nullptr) {
+                napi_release_threadsafe_function(data->holdedThreadSafeFunction, napi_tsfn_release);
+            }
+            delete data;
+        }
     }
 
     void JSFunctionForUI::Call() {
@@ -64,9 +80,20 @@ namespace DeskGap {
 
         delete data;
     }
+    void JSFunctionForUI::finalize_cb(napi_env env, void* finalizeData, void* finalizeHint) {
+        auto state = static_cast<std::shared_ptr<State>*>(finalizeData);
+        {
+            std::lock_guard<std::mutex> lock((*state)->mutex);
+            (*state)->threadsafeFunction = nullptr;
+        }
+        delete state;
+    }
+
     JSFunctionForUI::~JSFunctionForUI() {
-        napi_status status = napi_release_threadsafe_function(threadsafe_function_, napi_tsfn_release);
-        assert(status == napi_ok);
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->threadsafeFunction != nullptr) {
+            napi_release_threadsafe_function(state_->threadsafeFunction, napi_tsfn_release);
+        }
     }
 
     std::shared_ptr<JSFunctionForUI> JSFunctionForUI::Persist(const Napi::Function& func, bool holdWhileQueuing) {
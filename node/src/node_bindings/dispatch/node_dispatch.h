@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <functional>
+#include <mutex>
 #include <optional>
 #include <napi.h>
 #include <vector>
@@ -25,10 +26,17 @@ namespace DeskGap {
         void Call(JSArgsGetter&&);
         void Call();
     private:
+        // Shared with the finalizer of the thread-safe function, which runs when the env is torn down,
+        // for example when a worker is terminated. The calls made after that are dropped.
+        struct State {
+            std::mutex mutex;
+            napi_threadsafe_function threadsafeFunction = nullptr;
+        };
 
         bool holdWhileQueuing_;
-        napi_threadsafe_function threadsafe_function_;
+        std::shared_ptr<State> state_;
         static void call_js_cb(napi_env env, napi_value js_callback, void* context, void* data);
+        static void finalize_cb(napi_env env, void* finalizeData, void* finalizeHint);
         void Call_(std::optional<JSArgsGetter>&& getArgs);
     };
 }
@@ -0,0 +1,90 @@
+#ifndef ui_command_stream_h
+#define ui_command_stream_h
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <napi.h>
+#include <node_api.h>
+#include "action_arena.h"
+#include "event_channel.h"
+
+namespace DeskGap {
+    // The asynchronous dispatches of an env, drained by the UI thread in the order they are pushed.
+    // Only the push that makes the stream non-empty dispatches a drain, which runs everything pushed until then.
+    class UICommandStream: public std::enable_shared_from_this<UICommandStream> {
+    private:
+        std::mutex mutex_;
+        ActionArena pending_;
+        uint64_t pendingCount_ = 0;
+        bool isDrainScheduled_ = false;
+
+        // Used by the UI thread only
+        ActionArena draining_;
+        bool isDraining_ = false;
+
+        // Used by the node thread only
+        uint64_t pushedCount_ = 0;
+        // The JS objects of the wraps that the commands use, each with the count of the commands pushed when it is retained.
+        // The wraps are not finalized before the commands have run, and the references are released on the node thread.
+        std::deque<std::pair<uint64_t, Napi::ObjectReference>> retained_;
+
+        std::atomic<uint64_t> appliedCount_ { 0 };
+        // Tells a drain to wake the node thread to release the retained objects
+        std::atomic<bool> hasRetained_ { false };
+
+        // The events of the drains, sent through the event channel of the env
+        enum class DrainEvent: uint32_t {
+            APPLIED = 0, FAILED = 1
+        };
+        // Added by the first drain, and removed when the env is torn down.
+        // It does not keep the event loop alive, as the commands are run whether the node thread waits for them or not.
+        std::optional<EventTarget> drainEvents_;
+
+        void ScheduleDrain(napi_env env);
+        // Runs on the UI thread. The exceptions of the commands are thrown asynchronously by onError,
+        // which also releases the retained objects, as onApplied does.
+        void Drain(const EventSender& onApplied, const EventSender& onError);
+    public:
+        template <class Action>
+        void Push(napi_env env, std::initializer_list<Napi::Object> usedObjects, Action&& action) {
+            ++pushedCount_;
+            ReleaseRetained();
+            for (const Napi::Object& usedObject: usedObjects) {
+                retained_.emplace_back(pushedCount_, Napi::Persistent(usedObject));
+            }
+            if (usedObjects.size() > 0) {
+                // Seen by the drain that takes the command, as the command is pushed under the mutex
+                hasRetained_.store(true, std::memory_order_relaxed);
+            }
+            bool needsDrain;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pending_.Emplace(std::forward<Action>(action));
+                ++pendingCount_;
+                needsDrain = !isDrainScheduled_;
+                isDrainScheduled_ = true;
+            }
+            if (needsDrain) {
+                ScheduleDrain(env);
+            }
+        }
+
+        // State read on the node thread without dispatching (like BrowserWindow::GetState) is stale until this is false.
+        bool HasUnappliedCommands() const {
+            return appliedCount_.load(std::memory_order_acquire) != pushedCount_;
+        }
+
+        // Called on the node thread. Releases the objects of the commands that have run,
+        // or all of them and the drain events when the env is torn down.
+        void ReleaseRetained();
+        void ReleaseAllRetained();
+    };
+}
+
+#endif /* ui_command_stream_h */
@@ -1,5 +1,6 @@
-#include <queue>
+#include <chrono>
 #include <functional>
+#include <optional>
 #include <napi.h>
 #include <utility>
 #include "ui_dispatch.h"
@@ -10,36 +11,130 @@
 
 namespace {
     using namespace DeskGap;
-    bool shouldUISyncDispatchesBeDelayed = false;
-    std::queue<std::function<void()>> delayedUISyncActions;
+
+    // Half a frame at 60 Hz
+    constexpr auto kCommitSliceDuration = std::chrono::milliseconds(8);
 
     Napi::Value NativeExceptionToJSError(napi_env env, const Exception& exception) {
-        return NativeExceptionConstructor().New({
+        return NativeExceptionConstructor(env).New({
             Napi::String::New(env, exception.name),
             Napi::String::New(env, exception.message),
         });
     }
 }
 
-void DeskGap::DelayUISync() {
-    shouldUISyncDispatchesBeDelayed = true;
+void DeskGap::DelayUISync(napi_env env) {
+    ++EnvData::Of(env).uiTransactionDepth;
 }
 void DeskGap::CommitUISync(napi_env env) {
-    shouldUISyncDispatchesBeDelayed = false;
-    UISync(env, []() {
-        while (!delayedUISyncActions.empty()) {
-            delayedUISyncActions.front()();
-            delayedUISyncActions.pop();
+    EnvData& envData = EnvData::Of(env);
+    if (envData.uiTransactionDepth == 0 || --envData.uiTransactionDepth > 0) {
+        return;
+    }
+    ActionArena& delayedUISyncActions = envData.delayedUISyncActions;
+    std::optional<Napi::Error> firstError;
+    while (!delayedUISyncActions.Empty()) {
+        try {
+            UISync(env, [&delayedUISyncActions]() {
+                auto deadline = std::chrono::steady_clock::now() + kCommitSliceDuration;
+                delayedUISyncActions.RunUntil([deadline]() {
+                    return std::chrono::steady_clock::now() >= deadline;
+                });
+            });
         }
+        catch (const Napi::Error& error) {
+            // The actions after the one that throws are still run, so the promises queued by UIPromise are settled
+            if (!firstError.has_value()) {
+                firstError = error;
+            }
+        }
+    }
+    envData.objectsOfDelayedActions.clear();
+    if (firstError.has_value()) {
+        throw *firstError;
+    }
+}
+
+void DeskGap::UICommandStream::ScheduleDrain(napi_env env) {
+    if (!drainEvents_.has_value()) {
+        // The handlers run on the node thread while the env, which owns the stream, is alive
+        drainEvents_.emplace(env, std::vector<Napi::Function> {
+            Napi::Function::New(env, [this](const Napi::CallbackInfo&) {
+                this->ReleaseRetained();
+            }),
+            Napi::Function::New(env, [this](const Napi::CallbackInfo& info) {
+                this->ReleaseRetained();
+                throw info[0].As<Napi::Error>();
+            })
+        }, false);
+    }
+    DeskGap::DispatchAsync([
+        stream = shared_from_this(),
+        onApplied = drainEvents_->Sender(DrainEvent::APPLIED),
+        onError = drainEvents_->Sender(DrainEvent::FAILED)
+    ]() {
+        stream->Drain(onApplied, onError);
     });
 }
 
-void DeskGap::UISyncDelayable(napi_env env, std::function<void()>&& action) {
-    if (shouldUISyncDispatchesBeDelayed) {
-        delayedUISyncActions.emplace(std::move(action));
+void DeskGap::UICommandStream::Drain(const EventSender& onApplied, const EventSender& onError) {
+    // A command that spins a nested main loop may let a later drain run inside it.
+    // The outer drain runs the commands pushed in the meantime instead.
+    if (isDraining_) return;
+    isDraining_ = true;
+    while (true) {
+        uint64_t count;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            draining_.Swap(pending_);
+            count = pendingCount_;
+            pendingCount_ = 0;
+            isDrainScheduled_ = false;
+        }
+        if (count == 0) break;
+
+        while (!draining_.Empty()) {
+            std::optional<Exception> optionalException = DeskGap::TryCatch([this]() {
+                draining_.RunUntil([]() { return false; });
+            });
+            if (optionalException.has_value()) {
+                onError(MakeEventPayload([exception = std::move(*optionalException)](napi_env env) -> napi_value {
+                    return NativeExceptionToJSError(env, exception);
+                }));
+            }
+        }
+        appliedCount_.fetch_add(count, std::memory_order_release);
     }
-    else {
-        UISync(env, std::move(action));
+    isDraining_ = false;
+    if (hasRetained_.load(std::memory_order_relaxed)) {
+        onApplied();
+    }
+}
+
+void DeskGap::UICommandStream::ReleaseRetained() {
+    if (retained_.empty()) return;
+    uint64_t appliedCount = appliedCount_.load(std::memory_order_acquire);
+    while (!retained_.empty() && retained_.front().first <= appliedCount) {
+        retained_.pop_front();
+    }
+    if (retained_.empty()) {
+        hasRetained_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void DeskGap::UICommandStream::ReleaseAllRetained() {
+    retained_.clear();
+    hasRetained_.store(false, std::memory_order_relaxed);
+    // Removed on the node thread, even if a drain still holds the stream
+    drainEvents_.reset();
+}
+
+void DeskGap::WaitForUICommands(napi_env env) {
+    UICommandStream& stream = *EnvData::Of(env).uiCommandStream;
+    if (stream.HasUnappliedCommands()) {
+        // Dispatched after the drain of the commands
+        UISync(env, []() { });
+        stream.ReleaseRetained();
     }
 }
 
@@ -57,7 +152,7 @@ void DeskGap::UIASync(napi_env env, std::function<void()>&& action) {
     auto asyncThrowJSError = JSFunctionForUI::Persist(Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
         throw info[0].As<Napi::Error>();
     }));
-    DeskGap::DispatchAsync([ action { std::move(action) }, asyncThrowJSError { std::move(asyncThrowJSError) } ]() mutable {
+    EnvData::Of(env).uiCommandStream->Push(env, {}, [ action { std::move(action) }, asyncThrowJSError { std::move(asyncThrowJSError) } ]() mutable {
         std::optional<Exception> optionalException = DeskGap::TryCatch(std::move(action));
         if (optionalException.has_value()) {
             asyncThrowJSError->Call([exception = std::move(*optionalException), asyncThrowJSError](napi_env env) {
@@ -68,3 +163,45 @@ void DeskGap::UIASync(napi_env env, std::function<void()>&& action) {
         }
     });
 }
+
+Napi::Promise DeskGap::UIPromise(napi_env env, std::initializer_list<Napi::Object> usedObjects, std::function<JSValueGetter()>&& action) {
+    auto deferred = Napi::Promise::Deferred::New(env);
+    auto jsSettle = JSFunctionForUI::Persist(Napi::Function::New(env, [deferred](const Napi::CallbackInfo& info) {
+        if (info[0].IsNull()) {
+            deferred.Resolve(info[1]);
+        }
+        else {
+            deferred.Reject(info[0]);
+        }
+    }));
+
+    std::function<void()> settle = [action { std::move(action) }, jsSettle { std::move(jsSettle) }]() mutable {
+        JSValueGetter getResult;
+        std::optional<Exception> optionalException = DeskGap::TryCatch([&]() {
+            getResult = action();
+        });
+        if (optionalException.has_value()) {
+            jsSettle->Call([exception = std::move(*optionalException)](napi_env env) {
+                return std::vector<napi_value> {
+                    NativeExceptionToJSError(env, exception),
+                    Napi::Env(env).Undefined()
+                };
+            });
+        }
+        else {
+            jsSettle->Call([getResult = std::move(getResult)](napi_env env) {
+                return std::vector<napi_value> { Napi::Env(env).Null(), getResult(env) };
+            });
+        }
+    };
+
+    EnvData& envData = EnvData::Of(env);
+    if (envData.uiTransactionDepth > 0) {
+        envData.RetainForDelayedActions(usedObjects);
+        envData.delayedUISyncActions.Emplace(std::move(settle));
+    }
+    else {
+        envData.uiCommandStream->Push(env, usedObjects, std::move(settle));
+    }
+    return deferred.Promise();
+}
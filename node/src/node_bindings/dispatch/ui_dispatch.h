@@ -2,17 +2,61 @@
 #define ui_dispatch_h
 
 #include <functional>
+#include <initializer_list>
 #include <string>
+#include <utility>
+#include <napi.h>
 #include <node_api.h>
+#include "../env_data.h"
 
 namespace DeskGap {
     void UISync(napi_env env, std::function<void()>&& action);
 
-    void DelayUISync();
+    // DelayUISync begins a UI transaction, which can be nested. The delayable dispatches are queued until the outermost
+    // transaction commits, and a large commit is run in slices so the UI thread handles its events between them.
+    // The transactions are kept per env, so a worker thread does not delay the dispatches of the others.
+    void DelayUISync(napi_env env);
     void CommitUISync(napi_env env);
-    
-    void UISyncDelayable(napi_env env, std::function<void()>&& action);
+
+    template <class Action>
+    void UISyncDelayable(napi_env env, Action&& action) {
+        EnvData& envData = EnvData::Of(env);
+        if (envData.uiTransactionDepth > 0) {
+            envData.delayedUISyncActions.Emplace(std::forward<Action>(action));
+        }
+        else {
+            UISync(env, std::forward<Action>(action));
+        }
+    }
+
+    // Queues an action that returns nothing, like a setter, without waiting for the UI thread.
+    // The actions are run in order, before the later UISync, UIASync and UIPromise of the env, so a getter sees them.
+    // Native exceptions are thrown asynchronously. In a UI transaction, the action is delayed like UISyncDelayable.
+    // The JS objects of the wraps that the action uses are kept from being finalized until it has run.
+    template <class Action>
+    void UICommand(napi_env env, std::initializer_list<Napi::Object> usedObjects, Action&& action) {
+        EnvData& envData = EnvData::Of(env);
+        if (envData.uiTransactionDepth > 0) {
+            envData.RetainForDelayedActions(usedObjects);
+            envData.delayedUISyncActions.Emplace(std::forward<Action>(action));
+        }
+        else {
+            envData.uiCommandStream->Push(env, usedObjects, std::forward<Action>(action));
+        }
+    }
+
+    // Waits for the queued UI commands of the env to be run,
+    // so the state read without dispatching to the UI thread is up to date.
+    void WaitForUICommands(napi_env env);
+
     void UIASync(napi_env env, std::function<void()>&& action);
+
+    // Runs the action on the UI thread without blocking the node thread.
+    // The action returns a getter that converts its result on the node thread, which resolves the promise.
+    // Native exceptions reject the promise. Actions delayed by DelayUISync are run before it.
+    // The used objects are retained like those of UICommand.
+    using JSValueGetter = std::function<napi_value(napi_env)>;
+    Napi::Promise UIPromise(napi_env env, std::initializer_list<Napi::Object> usedObjects, std::function<JSValueGetter()>&& action);
 }
 
 #endif /* ui_dispatch_h */
@@ -0,0 +1,56 @@
+#ifndef env_data_h
+#define env_data_h
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include <napi.h>
+#include "dispatch/action_arena.h"
+#include "dispatch/event_channel.h"
+#include "dispatch/ui_command_stream.h"
+#include "live_native_objects.h"
+
+namespace DeskGap {
+    // The state of the bindings that belongs to one Node environment.
+    // The main thread and every worker thread that loads deskgap have their own one, stored as the instance data of the env.
+    struct EnvData {
+        // The main env is the first one to load the bindings, which kBootstrapScript does before running any script of the app.
+        bool isMainEnv;
+
+        // The depth of the nested UI transactions. The delayable dispatches are queued while it is not zero.
+        uint32_t uiTransactionDepth = 0;
+        ActionArena delayedUISyncActions;
+        // The JS objects of the wraps that the delayed actions use, released when they have run
+        std::vector<Napi::ObjectReference> objectsOfDelayedActions;
+
+        // Shared with the drains dispatched to the UI thread, which may outlive the env
+        std::shared_ptr<UICommandStream> uiCommandStream = std::make_shared<UICommandStream>();
+
+        // The events of the native objects of the env, delivered to their JS handlers
+        std::shared_ptr<EventChannel> eventChannel;
+
+        // Shared with the wraps, which may be finalized after the env data is deleted
+        std::shared_ptr<LiveNativeObjects> liveNativeObjects = std::make_shared<LiveNativeObjects>();
+
+        Napi::FunctionReference nativeExceptionConstructor;
+
+        EnvData(napi_env env, bool isMainEnv): isMainEnv(isMainEnv), eventChannel(EventChannel::Create(env)) { }
+        ~EnvData() {
+            uiCommandStream->ReleaseAllRetained();
+            eventChannel->Close();
+        }
+
+        void RetainForDelayedActions(std::initializer_list<Napi::Object> usedObjects) {
+            for (const Napi::Object& usedObject: usedObjects) {
+                objectsOfDelayedActions.push_back(Napi::Persistent(usedObject));
+            }
+        }
+
+        static EnvData& Of(napi_env env) {
+            return *Napi::Env(env).GetInstanceData<EnvData>();
+        }
+    };
+}
+
+#endif /* env_data_h */
@@ -1,3 +1,5 @@
+#include <atomic>
+#include <cassert>
 #include <memory>
 #include <sstream>
 #include <napi.h>
@@ -11,27 +13,52 @@
 #include "system_preferences/system_preferences_wrap.h"
 #include "dialog/dialog_wrap.h"
 #include "dispatch/dispatch.h"
+#include "env_data.h"
 #include "native_exception.h"
 
+extern "C" {
+    extern char BIN2CODE_DG_NODE_JS_CONTENT[];
+    extern int BIN2CODE_DG_NODE_JS_SIZE;
+}
+
 namespace {
-    std::unique_ptr<Napi::FunctionReference> nativeExceptionConstructor;
+    std::atomic<bool> hasMainEnv { false };
 
     inline void ExportFunction(Napi::Object& exports, const Napi::Function& function) {
         exports.Set(function.Get("name"), function);
     }
+
+    // A worker that is terminated or exits with some native objects alive must not leave them behind,
+    // because their events and the UI commands queued for them would reach the wraps after they are freed
+    void CleanUpWorkerEnv(void* arg) {
+        auto env = static_cast<napi_env>(arg);
+        DeskGap::EnvData& envData = DeskGap::EnvData::Of(env);
+        envData.delayedUISyncActions.Clear();
+        envData.objectsOfDelayedActions.clear();
+        // Dispatched after the UI commands that are queued
+        envData.liveNativeObjects->DestroyAll();
+        envData.eventChannel->Close();
+    }
 }
 
 
 Napi::Object DeskGap::InitNodeNativeModule(Napi::Env env, Napi::Object exports) {
+    auto envData = new EnvData(env, !hasMainEnv.exchange(true));
+    env.SetInstanceData(envData);
+    if (!envData->isMainEnv) {
+        // Run before the wraps are finalized, as the hooks of an env are run in the reverse order of their addition
+        napi_status status = napi_add_env_cleanup_hook(env, CleanUpWorkerEnv, static_cast<napi_env>(env));
+        assert(status == napi_ok);
+    }
+
     exports.Set("appNative", DeskGap::AppWrap::AppObject(env));
     ExportFunction(exports, DeskGap::BrowserWindowWrap::Constructor(env));
     ExportFunction(exports, DeskGap::MenuWrap::Constructor(env));
-    ExportFunction(exports, DeskGap::MenuItemWrap::Constructor(env));
     ExportFunction(exports, DeskGap::WebViewWrap::Constructor(env));
     ExportFunction(exports, DeskGap::TrayWrap::Constructor(env));
 
-    ExportFunction(exports, Napi::Function::New(env, [](const Napi::CallbackInfo&) {
-        DeskGap::DelayUISync();
+    ExportFunction(exports, Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        DeskGap::DelayUISync(info.Env());
     }, "delayUISync"));
 
     ExportFunction(exports, Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
@@ -39,9 +66,14 @@ Napi::Object DeskGap::InitNodeNativeModule(Napi::Env env, Napi::Object exports)
     }, "commitUISync"));
 
     ExportFunction(exports, Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
-        nativeExceptionConstructor = std::make_unique<Napi::FunctionReference>(Persistent(info[0].As<Napi::Function>()));
+        EnvData::Of(info.Env()).nativeExceptionConstructor = Persistent(info[0].As<Napi::Function>());
     }, "setNativeExceptionConstructor"));
 
+    // Worker threads evaluate the bundle by themselves, see js/node/worker.ts
+    ExportFunction(exports, Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        return Napi::String::New(info.Env(), BIN2CODE_DG_NODE_JS_CONTENT, BIN2CODE_DG_NODE_JS_SIZE);
+    }, "getNodeScript"));
+
     exports.Set("shellNative", DeskGap::ShellObject(env));
     exports.Set("systemPreferencesNative", DeskGap::SystemPreferencesObject(env));
     exports.Set("dialogNative", DeskGap::DialogObject(env));
@@ -49,6 +81,6 @@ Napi::Object DeskGap::InitNodeNativeModule(Napi::Env env, Napi::Object exports)
     return exports;
 }
 
-const Napi::FunctionReference& DeskGap::NativeExceptionConstructor() {
-    return *nativeExceptionConstructor;
+const Napi::FunctionReference& DeskGap::NativeExceptionConstructor(napi_env env) {
+    return EnvData::Of(env).nativeExceptionConstructor;
 }
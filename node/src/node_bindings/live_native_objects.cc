@@ -0,0 +1,63 @@
+#include <utility>
+#include <vector>
+#include <deskgap/dispatch.hpp>
+#include <deskgap/exception.hpp>
+#include "live_native_objects.h"
+#include "env_data.h"
+
+namespace DeskGap {
+    uint64_t LiveNativeObjects::Add(Kind kind, std::function<void()>&& destroy) {
+        uint64_t id = ++lastId_;
+        destroyers_[static_cast<size_t>(kind)].emplace(id, std::move(destroy));
+        return id;
+    }
+
+    void LiveNativeObjects::Remove(Kind kind, uint64_t id) {
+        destroyers_[static_cast<size_t>(kind)].erase(id);
+    }
+
+    void LiveNativeObjects::DestroyAll() {
+        std::vector<std::function<void()>> destroyers;
+        for (auto& destroyersOfKind: destroyers_) {
+            for (auto& [id, destroy]: destroyersOfKind) {
+                destroyers.push_back(std::move(destroy));
+            }
+            destroyersOfKind.clear();
+        }
+        if (destroyers.empty()) return;
+
+        // Not UISync, whose errors are JS errors, which cannot be made while the env is torn down
+        DispatchSync([&destroyers]() {
+            for (auto& destroy: destroyers) {
+                DeskGap::TryCatch(std::move(destroy));
+            }
+        });
+    }
+
+    LiveNativeObject::LiveNativeObject(napi_env env, LiveNativeObjects::Kind kind, std::function<void()>&& destroy):
+        objects_(EnvData::Of(env).liveNativeObjects), kind_(kind), id_(objects_->Add(kind, std::move(destroy))) { }
+
+    LiveNativeObject::LiveNativeObject(LiveNativeObject&& other) noexcept:
+        objects_(std::move(other.objects_)), kind_(other.kind_), id_(other.id_) { }
+
+    LiveNativeObject& LiveNativeObject::operator=(LiveNativeObject&& other) noexcept {
+        if (this != &other) {
+            Remove();
+            objects_ = std::move(other.objects_);
+            kind_ = other.kind_;
+            id_ = other.id_;
+        }
+        return *this;
+    }
+
+    LiveNativeObject::~LiveNativeObject() {
+        Remove();
+    }
+
+    void LiveNativeObject::Remove() {
+        if (objects_ != nullptr) {
+            objects_->Remove(kind_, id_);
+            objects_.reset();
+        }
+    }
+}
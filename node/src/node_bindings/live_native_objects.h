@@ -0,0 +1,53 @@
+#ifndef live_native_objects_h
+#define live_native_objects_h
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <node_api.h>
+
+namespace DeskGap {
+    // The native objects of the wraps of an env that have not been destroyed by JS.
+    // When a worker env is torn down with some of them alive, they are destroyed on the UI thread before the wraps are freed,
+    // so neither their events nor the UI commands still queued for them reach a freed wrap.
+    class LiveNativeObjects {
+    public:
+        // The order they are destroyed in: a window before its WebView and its menu
+        enum class Kind: size_t {
+            WINDOW = 0, WEBVIEW = 1, TRAY = 2, MENU = 3
+        };
+    private:
+        static constexpr size_t kKindCount = 4;
+        uint64_t lastId_ = 0;
+        // By the order they are added in. The destroyers are run on the UI thread.
+        std::array<std::map<uint64_t, std::function<void()>>, kKindCount> destroyers_;
+    public:
+        // Called on the Node thread
+        uint64_t Add(Kind kind, std::function<void()>&& destroy);
+        void Remove(Kind kind, uint64_t id);
+
+        // Called on the Node thread when the env is torn down. Runs after the UI commands queued before it.
+        void DestroyAll();
+    };
+
+    // The entry of a wrap in the LiveNativeObjects of its env, removed when the wrap destroys its native object or is finalized
+    class LiveNativeObject {
+    private:
+        std::shared_ptr<LiveNativeObjects> objects_;
+        LiveNativeObjects::Kind kind_ = LiveNativeObjects::Kind::WINDOW;
+        uint64_t id_ = 0;
+    public:
+        LiveNativeObject() = default;
+        LiveNativeObject(napi_env env, LiveNativeObjects::Kind kind, std::function<void()>&& destroy);
+        LiveNativeObject(LiveNativeObject&& other) noexcept;
+        LiveNativeObject& operator=(LiveNativeObject&& other) noexcept;
+        ~LiveNativeObject();
+
+        void Remove();
+    };
+}
+
+#endif /* live_native_objects_h */
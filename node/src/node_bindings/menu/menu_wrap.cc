@@ -1,124 +1,241 @@
 #include "menu_wrap.h"
 #include <deskgap/menu.hpp>
 #include "../dispatch/dispatch.h"
+#include <functional>
 #include <memory>
+#include <sstream>
 #include <vector>
 
+namespace {
+    std::vector<std::string> SplitAcceleratorTokens(const std::string& joinedTokens) {
+        std::vector<std::string> tokens;
+        std::istringstream tokenStream(joinedTokens);
+        for (std::string token; tokenStream >> token;) {
+            tokens.push_back(std::move(token));
+        }
+        return tokens;
+    }
+}
+
 namespace DeskGap {
-    //MenuItemWrap Implementations Begin
-    Napi::Function MenuItemWrap::Constructor(const Napi::Env& env) {
-        return DefineClass(env, "MenuItemNative", {
-            InstanceMethod("setLabel", &MenuItemWrap::SetLabel),
-            InstanceMethod("getLabel", &MenuItemWrap::GetLabel),
-            InstanceMethod("setEnabled", &MenuItemWrap::SetEnabled),
-            InstanceMethod("setChecked", &MenuItemWrap::SetChecked),
-            InstanceMethod("setAccelerator", &MenuItemWrap::SetAccelerator),
-            InstanceMethod("destroy", &MenuItemWrap::Destroy),
+    //MenuWrap Implementations Begin
+
+    Napi::Function MenuWrap::Constructor(const Napi::Env& env) {
+        return DefineClass(env, "MenuNative", {
+            InstanceMethod("appendTemplate", &MenuWrap::AppendTemplate),
+            InstanceMethod("patchTemplate", &MenuWrap::PatchTemplate),
+            InstanceMethod("setTemplateItemEnabled", &MenuWrap::SetTemplateItemEnabled),
+            InstanceMethod("setTemplateItemChecked", &MenuWrap::SetTemplateItemChecked),
+            InstanceMethod("destroy", &MenuWrap::Destroy)
         });
     }
 
-    MenuItemWrap::MenuItemWrap(const Napi::CallbackInfo& info):
-            Napi::ObjectWrap<MenuItemWrap>(info)
+    MenuWrap::MenuWrap(const Napi::CallbackInfo& info):
+        Napi::ObjectWrap<MenuWrap>(info)
     {
-        std::string role = info[0].As<Napi::String>().Utf8Value();
-        MenuItem::Type type = static_cast<MenuItem::Type>(info[1].As<Napi::Number>().Int32Value());
+        Menu::Type menuType = static_cast<Menu::Type>(info[0].As<Napi::Number>().Int32Value());
+        UISyncDelayable(info.Env(), [this, menuType]() {
+            this->menu_ = std::make_unique<Menu>(menuType);
+        });
+        liveObject_ = LiveNativeObject(info.Env(), LiveNativeObjects::Kind::MENU, [this] {
+            this->templateItems_.clear();
+            this->menu_.reset();
+        });
+    }
+    MenuItem& MenuWrap::BuildTemplateItem(Menu& parentMenu, const std::vector<TemplateItemOptions>& options, size_t& index) {
+        const TemplateItemOptions& itemOptions = options[index++];
+        TemplateItem& item = templateItems_[itemOptions.id];
+        item.parentMenu = &parentMenu;
 
-        MenuWrap* wrappedSubmenu = nullptr;
-        if (!info[2].IsNull()) {
-            wrappedSubmenu = MenuWrap::Unwrap(info[2].ToObject());
+        if (itemOptions.childCount >= 0) {
+            Menu::EventCallbacks submenuCallbacks;
+            if (itemOptions.reportsSubmenuVisibility) {
+                submenuCallbacks.onShow = TemplateItemEventSender(itemOptions.id, TemplateItemEvent::SUBMENU_SHOW);
+                submenuCallbacks.onHide = TemplateItemEventSender(itemOptions.id, TemplateItemEvent::SUBMENU_HIDE);
+            }
+            item.submenu = std::make_unique<Menu>(Menu::Type::SUBMENU, std::move(submenuCallbacks));
+            BuildTemplateItems(*item.submenu, options, index, itemOptions.childCount);
         }
 
-
-        MenuItem::EventCallbacks eventCallbacks {
-            [jsOnClick = JSFunctionForUI::Persist(info[3].As<Napi::Function>(), true)]() {
-                jsOnClick->Call();
-            }
-        };
-        UISyncDelayable(info.Env(), [this, role, type, wrappedSubmenu, eventCallbacks = std::move(eventCallbacks)]() mutable {
-            Menu* submenu = nullptr;
-            if (wrappedSubmenu != nullptr) {
-                submenu = wrappedSubmenu->menu_.get();
-            }
-            this->menu_item_ = std::make_unique<MenuItem>(role, type, submenu, std::move(eventCallbacks));
+        item.menuItem = std::make_unique<MenuItem>(itemOptions.role, itemOptions.type, item.submenu.get(), MenuItem::EventCallbacks {
+            TemplateItemEventSender(itemOptions.id, TemplateItemEvent::CLICK)
         });
+        item.menuItem->SetEnabled(itemOptions.enabled);
+        item.menuItem->SetLabel(itemOptions.label);
+        item.menuItem->SetChecked(itemOptions.checked);
+        item.menuItem->SetAccelerator(itemOptions.acceleratorTokens);
+        return *item.menuItem;
     }
 
-    Napi::Value MenuItemWrap::GetLabel(const Napi::CallbackInfo& info) {
-        std::string label;
-        UISync(info.Env(), [&]() {
-            label = menu_item_->GetLabel();
-        });
-        return Napi::String::New(info.Env(), label);
+    std::function<void()> MenuWrap::TemplateItemEventSender(uint32_t id, TemplateItemEvent event) const {
+        return [sender = templateEvents_.Sender(event), id]() {
+            sender(id);
+        };
     }
 
-    void MenuItemWrap::SetLabel(const Napi::CallbackInfo& info) {
-        std::string label = info[0].As<Napi::String>();
-        UISyncDelayable(info.Env(), [this, label]() {
-            this->menu_item_->SetLabel(label);
-        });
-    }
-    void MenuItemWrap::SetEnabled(const Napi::CallbackInfo& info) {
-        bool enabled = info[0].As<Napi::Boolean>().Value();
-        UISyncDelayable(info.Env(), [this, enabled]() {
-            this->menu_item_->SetEnabled(enabled);
-        });
+    void MenuWrap::BuildTemplateItems(Menu& menu, const std::vector<TemplateItemOptions>& options, size_t& index, size_t count) {
+        for (size_t i = 0; i < count && index < options.size(); ++i) {
+            menu.AppendItem(BuildTemplateItem(menu, options, index));
+        }
     }
-    void MenuItemWrap::SetChecked(const Napi::CallbackInfo& info) {
-        bool checked = info[0].As<Napi::Boolean>().Value();
-        UISyncDelayable(info.Env(), [this, checked]() {
-            this->menu_item_->SetChecked(checked);
-        });
+
+    MenuWrap::TemplateItemOptions MenuWrap::ReadTemplateItemOptions(const Napi::Array& jsArray, uint32_t offset) {
+        return {
+            jsArray.Get(offset).As<Napi::Number>().Uint32Value(),
+            static_cast<MenuItem::Type>(jsArray.Get(offset + 1).As<Napi::Number>().Int32Value()),
+            jsArray.Get(offset + 2).As<Napi::String>().Utf8Value(),
+            jsArray.Get(offset + 3).As<Napi::String>().Utf8Value(),
+            jsArray.Get(offset + 4).As<Napi::Boolean>().Value(),
+            jsArray.Get(offset + 5).As<Napi::Boolean>().Value(),
+            SplitAcceleratorTokens(jsArray.Get(offset + 6).As<Napi::String>().Utf8Value()),
+            jsArray.Get(offset + 7).As<Napi::Number>().Int32Value(),
+            jsArray.Get(offset + 8).As<Napi::Boolean>().Value()
+        };
     }
-    void MenuItemWrap::SetAccelerator(const Napi::CallbackInfo& info) {
-        std::vector<std::string> tokens;
-        Napi::Array tokenJSArray = info[0].As<Napi::Array>();
-        uint32_t jsArrayLength = tokenJSArray.Length();
-        for (uint32_t i = 0; i < jsArrayLength; ++i) {
-            tokens.push_back(tokenJSArray.Get(i).As<Napi::String>().Utf8Value());
+
+    void MenuWrap::AppendTemplate(const Napi::CallbackInfo& info) {
+        Napi::Array jsOptions = info[0].As<Napi::Array>();
+        uint32_t length = jsOptions.Length();
+
+        std::vector<TemplateItemOptions> options;
+        options.reserve(length / kTemplateItemFieldCount);
+        for (uint32_t i = 0; i + kTemplateItemFieldCount <= length; i += kTemplateItemFieldCount) {
+            options.push_back(ReadTemplateItemOptions(jsOptions, i));
         }
-        UISyncDelayable(info.Env(), [this, tokens]() {
-            this->menu_item_->SetAccelerator(tokens);
-        });
-    }
 
-    void MenuItemWrap::Destroy(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this]() {
-            this->menu_item_.reset();
+        Napi::Object jsCallbacks = info[1].As<Napi::Object>();
+        templateEvents_ = EventTarget(info.Env(), {
+            jsCallbacks.Get("onClick").As<Napi::Function>(),
+            jsCallbacks.Get("onSubmenuShow").As<Napi::Function>(),
+            jsCallbacks.Get("onSubmenuHide").As<Napi::Function>()
+        });
+        UISyncDelayable(info.Env(), [this, options = std::move(options)]() mutable {
+            size_t index = 0;
+            BuildTemplateItems(*(this->menu_), options, index, options.size());
         });
     }
-    //MenuItemWrap Implementations End
 
+    void MenuWrap::PatchTemplate(const Napi::CallbackInfo& info) {
+        Napi::Array jsPatches = info[0].As<Napi::Array>();
+        uint32_t length = jsPatches.Length();
+        const auto readUint32 = [&](uint32_t index) {
+            return jsPatches.Get(index).As<Napi::Number>().Uint32Value();
+        };
 
-    //MenuWrap Implementations Begin
+        // Read here and applied in one go on the UI thread, touching only the items in the patches
+        std::vector<std::function<void()>> actions;
+        uint32_t i = 0;
+        while (i < length) {
+            auto type = static_cast<TemplatePatchType>(jsPatches.Get(i).As<Napi::Number>().Int32Value());
+            switch (type) {
+            case TemplatePatchType::REMOVE: {
+                uint32_t idCount = readUint32(i + 1);
+                std::vector<uint32_t> ids;
+                ids.reserve(idCount);
+                for (uint32_t j = 0; j < idCount; ++j) {
+                    ids.push_back(readUint32(i + 2 + j));
+                }
+                i += 2 + idCount;
+                actions.emplace_back([this, ids = std::move(ids)]() {
+                    if (ids.empty()) return;
+                    TemplateItem& item = this->templateItems_.at(ids.front());
+                    item.parentMenu->RemoveItem(*item.menuItem);
+                    // Descendants first, so that no item outlives the menu it is in
+                    for (auto it = ids.rbegin(); it != ids.rend(); ++it) {
+                        this->templateItems_.erase(*it);
+                    }
+                });
+                break;
+            }
+            case TemplatePatchType::INSERT: {
+                int32_t parentId = jsPatches.Get(i + 1).As<Napi::Number>().Int32Value();
+                uint32_t index = readUint32(i + 2);
+                uint32_t itemCount = readUint32(i + 3);
+                std::vector<TemplateItemOptions> options;
+                options.reserve(itemCount);
+                for (uint32_t j = 0; j < itemCount; ++j) {
+                    options.push_back(ReadTemplateItemOptions(jsPatches, i + 4 + j * kTemplateItemFieldCount));
+                }
+                i += 4 + itemCount * kTemplateItemFieldCount;
+                actions.emplace_back([this, parentId, index, options = std::move(options)]() {
+                    if (options.empty()) return;
+                    Menu& parentMenu = parentId < 0 ? *(this->menu_) : *(this->templateItems_.at(parentId).submenu);
+                    size_t optionIndex = 0;
+                    parentMenu.InsertItem(BuildTemplateItem(parentMenu, options, optionIndex), index);
+                });
+                break;
+            }
+            case TemplatePatchType::SET_LABEL: {
+                uint32_t id = readUint32(i + 1);
+                std::string label = jsPatches.Get(i + 2).As<Napi::String>().Utf8Value();
+                i += 3;
+                actions.emplace_back([this, id, label = std::move(label)]() {
+                    this->templateItems_.at(id).menuItem->SetLabel(label);
+                });
+                break;
+            }
+            case TemplatePatchType::SET_ENABLED: {
+                uint32_t id = readUint32(i + 1);
+                bool enabled = jsPatches.Get(i + 2).As<Napi::Boolean>().Value();
+                i += 3;
+                actions.emplace_back([this, id, enabled]() {
+                    this->templateItems_.at(id).menuItem->SetEnabled(enabled);
+                });
+                break;
+            }
+            case TemplatePatchType::SET_CHECKED: {
+                uint32_t id = readUint32(i + 1);
+                bool checked = jsPatches.Get(i + 2).As<Napi::Boolean>().Value();
+                i += 3;
+                actions.emplace_back([this, id, checked]() {
+                    this->templateItems_.at(id).menuItem->SetChecked(checked);
+                });
+                break;
+            }
+            case TemplatePatchType::SET_ACCELERATOR: {
+                uint32_t id = readUint32(i + 1);
+                std::vector<std::string> tokens = SplitAcceleratorTokens(jsPatches.Get(i + 2).As<Napi::String>().Utf8Value());
+                i += 3;
+                actions.emplace_back([this, id, tokens = std::move(tokens)]() {
+                    this->templateItems_.at(id).menuItem->SetAccelerator(tokens);
+                });
+                break;
+            }
+            default:
+                throw Napi::Error::New(info.Env(), "Unknown menu patch type");
+            }
+        }
 
-    Napi::Function MenuWrap::Constructor(const Napi::Env& env) {
-        return DefineClass(env, "MenuNative", {
-            InstanceMethod("append", &MenuWrap::Append),
-            InstanceMethod("destroy", &MenuWrap::Destroy)
+        UICommand(info.Env(), { Value() }, [actions = std::move(actions)]() {
+            for (const auto& action: actions) {
+                action();
+            }
         });
     }
 
-    MenuWrap::MenuWrap(const Napi::CallbackInfo& info):
-        Napi::ObjectWrap<MenuWrap>(info)
-    {
-        Menu::Type menuType = static_cast<Menu::Type>(info[0].As<Napi::Number>().Int32Value());
-        UISyncDelayable(info.Env(), [this, menuType]() {
-            this->menu_ = std::make_unique<Menu>(menuType);
+    void MenuWrap::SetTemplateItemEnabled(const Napi::CallbackInfo& info) {
+        uint32_t id = info[0].As<Napi::Number>().Uint32Value();
+        bool enabled = info[1].As<Napi::Boolean>().Value();
+        UICommand(info.Env(), { Value() }, [this, id, enabled]() {
+            this->templateItems_.at(id).menuItem->SetEnabled(enabled);
         });
     }
-    void MenuWrap::Append(const Napi::CallbackInfo& info) {
-        Napi::Object jsMenuItem = info[0].As<Napi::Object>();
-        MenuItemWrap* wrappedMenuItem = MenuItemWrap::Unwrap(jsMenuItem);
-        
-        UISyncDelayable(info.Env(), [this, wrappedMenuItem] {
-            this->menu_->AppendItem(*(wrappedMenuItem->menu_item_)); 
+
+    void MenuWrap::SetTemplateItemChecked(const Napi::CallbackInfo& info) {
+        uint32_t id = info[0].As<Napi::Number>().Uint32Value();
+        bool checked = info[1].As<Napi::Boolean>().Value();
+        UICommand(info.Env(), { Value() }, [this, id, checked]() {
+            this->templateItems_.at(id).menuItem->SetChecked(checked);
         });
     }
 
     void MenuWrap::Destroy(const Napi::CallbackInfo& info) {
         UISyncDelayable(info.Env(), [this]() {
+            this->templateItems_.clear();
             this->menu_.reset();
         });
+        templateEvents_.Remove();
+        liveObject_.Remove();
     }
     //MenuWrap Implementations End
 }
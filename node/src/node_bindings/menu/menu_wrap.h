@@ -2,39 +2,80 @@
 #define menu_menu_wrap_h
 
 #include <deskgap/menu.hpp>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <napi.h>
+#include "../dispatch/event_channel.h"
+#include "../live_native_objects.h"
 //#include "menu.h"
 
 namespace DeskGap {
-    class MenuItemWrap : public Napi::ObjectWrap<MenuItemWrap> {
-      private:
-        friend class MenuWrap;
-        std::unique_ptr<MenuItem> menu_item_;
-
-        void SetLabel(const Napi::CallbackInfo &info);
-        Napi::Value GetLabel(const Napi::CallbackInfo &info);
-        void SetEnabled(const Napi::CallbackInfo &info);
-        void SetChecked(const Napi::CallbackInfo &info);
-        void SetAccelerator(const Napi::CallbackInfo &info);
-        void Destroy(const Napi::CallbackInfo &info);
-
-      public:
-        MenuItemWrap(const Napi::CallbackInfo &info);
-
-        static Napi::Function Constructor(const Napi::Env &env);
-    };
-
     class MenuWrap : public Napi::ObjectWrap<MenuWrap> {
       private:
-        friend class MenuItemWrap;
         friend class BrowserWindowWrap;
         friend class AppWrap;
         friend class TrayWrap;
 
         std::unique_ptr<Menu> menu_;
-        void Append(const Napi::CallbackInfo &info);
+
+        // A menu item of a template, serialized by Menu#createNative_ in js/node/menu.ts as
+        // [id, type, role, label, enabled, checked, accelerator tokens joined by spaces, child count (-1 without a submenu),
+        // whether the showing and hiding of the submenu are reported] and followed by its children.
+        // A lazy submenu in js/node/menu.ts reports them to be filled when it is shown.
+        struct TemplateItemOptions {
+            uint32_t id;
+            MenuItem::Type type;
+            std::string role;
+            std::string label;
+            bool enabled;
+            bool checked;
+            std::vector<std::string> acceleratorTokens;
+            int32_t childCount;
+            bool reportsSubmenuVisibility;
+        };
+        static constexpr uint32_t kTemplateItemFieldCount = 9;
+
+        // The types of the events in templateEvents_, sent with the id of the item
+        enum class TemplateItemEvent: uint32_t {
+            CLICK = 0, SUBMENU_SHOW = 1, SUBMENU_HIDE = 2
+        };
+
+        static TemplateItemOptions ReadTemplateItemOptions(const Napi::Array& jsArray, uint32_t offset);
+
+        // The items built by AppendTemplate and PatchTemplate, owned by this menu. The item is declared after its submenu to be destroyed first.
+        struct TemplateItem {
+            Menu* parentMenu;
+            std::unique_ptr<Menu> submenu;
+            std::unique_ptr<MenuItem> menuItem;
+        };
+        std::unordered_map<uint32_t, TemplateItem> templateItems_;
+        // Shared by all the items of the template, which are told apart by their ids
+        EventTarget templateEvents_;
+        // Destroys the native object if the env of a worker is torn down before it is destroyed
+        LiveNativeObject liveObject_;
+        std::function<void()> TemplateItemEventSender(uint32_t id, TemplateItemEvent event) const;
+
+        // Builds the item options[index] with its submenu, and leaves index after its last descendant.
+        // The item is not added to parentMenu.
+        MenuItem& BuildTemplateItem(Menu& parentMenu, const std::vector<TemplateItemOptions>& options, size_t& index);
+        void BuildTemplateItems(Menu& menu, const std::vector<TemplateItemOptions>& options, size_t& index, size_t count);
+
+        // The operations of Menu#update in js/node/menu.ts, one after another in a flat array:
+        //     [REMOVE, id count, ids of the item and its descendants in pre-order...]
+        //     [INSERT, parent id (-1 for this menu), index, item count, serialized items...]
+        //     [SET_LABEL | SET_ENABLED | SET_CHECKED | SET_ACCELERATOR, id, value]
+        enum class TemplatePatchType: int {
+            REMOVE = 0, INSERT = 1, SET_LABEL = 2, SET_ENABLED = 3, SET_CHECKED = 4, SET_ACCELERATOR = 5
+        };
+
+        void AppendTemplate(const Napi::CallbackInfo &info);
+        void PatchTemplate(const Napi::CallbackInfo &info);
+        void SetTemplateItemEnabled(const Napi::CallbackInfo &info);
+        void SetTemplateItemChecked(const Napi::CallbackInfo &info);
         void Destroy(const Napi::CallbackInfo &info);
 
       public:
@@ -4,7 +4,7 @@
 #include <napi.h>
 
 namespace DeskGap {
-    const Napi::FunctionReference& NativeExceptionConstructor();
+    const Napi::FunctionReference& NativeExceptionConstructor(napi_env env);
 }
 
 #endif /* native_exception_h */
@@ -46,19 +46,24 @@ namespace DeskGap {
 
         Napi::Object jsCallbacks = info[1].As<Napi::Object>();
 
-        Napi::Function jsOnClick = jsCallbacks.Get("onClick").As<Napi::Function>();
-        Napi::Function jsOnDoubleClick = jsCallbacks.Get("onDoubleClick").As<Napi::Function>();
-        Napi::Function jsOnRightClick = jsCallbacks.Get("onRightClick").As<Napi::Function>();
+        events_ = EventTarget(info.Env(), {
+            jsCallbacks.Get("onClick").As<Napi::Function>(),
+            jsCallbacks.Get("onDoubleClick").As<Napi::Function>(),
+            jsCallbacks.Get("onRightClick").As<Napi::Function>(),
+        });
 
         Tray::EventCallbacks eventCallbacks{
-            [jsOnClick = JSFunctionForUI::Persist(jsOnClick, true)]() { jsOnClick->Call(); },
-            [jsonDoubleClick = JSFunctionForUI::Persist(jsOnDoubleClick, true)]() { jsonDoubleClick->Call(); },
-            [jsOnRightClick = JSFunctionForUI::Persist(jsOnRightClick, true)]() { jsOnRightClick->Call(); },
+            events_.Sender(Event::CLICK),
+            events_.Sender(Event::DOUBLE_CLICK),
+            events_.Sender(Event::RIGHT_CLICK),
         };
 
         UISyncDelayable(info.Env(), [this, iconPath, eventCallbacks = std::move(eventCallbacks)]() {
             this->tray_ = std::make_unique<Tray>(iconPath, std::move(eventCallbacks));
         });
+        liveObject_ = LiveNativeObject(info.Env(), LiveNativeObjects::Kind::TRAY, [this] {
+            this->tray_.reset();
+        });
     }
 
     Napi::Function TrayWrap::Constructor(const Napi::Env &env) {
@@ -5,11 +5,20 @@
 #include <functional>
 #include <memory>
 #include <napi.h>
+#include "../dispatch/event_channel.h"
+#include "../live_native_objects.h"
 
 namespace DeskGap {
     class TrayWrap : public Napi::ObjectWrap<TrayWrap> {
       private:
         std::unique_ptr<Tray> tray_;
+
+        // The types of the events in events_, in the order of the handlers
+        enum class Event : uint32_t { CLICK = 0, DOUBLE_CLICK = 1, RIGHT_CLICK = 2 };
+        EventTarget events_;
+        // Destroys the native object if the env of a worker is torn down before it is destroyed
+        LiveNativeObject liveObject_;
+
         void SetTooltip(const Napi::CallbackInfo &info);
         void SetIcon(const Napi::CallbackInfo &info);
         void SetTitle(const Napi::CallbackInfo &info);
@@ -1,3 +1,6 @@
+#include <cstring>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 #include <utility>
 #include <functional>
@@ -21,7 +24,34 @@ namespace DeskGap::JSNativeConvertion {
     }
 
 
+    // Declares the fields of a struct as (JS property name, member) pairs,
+    // so the struct is converted from and to a JS object without a hand-written specialization:
+    //     template<>
+    //     struct Reflection<FileFilter> {
+    //         static constexpr auto fields = std::make_tuple(
+    //             Field("name", &FileFilter::name),
+    //             Field("extensions", &FileFilter::extensions)
+    //         );
+    //     };
     template<class T>
+    struct Reflection;
+
+    template<class S, class M>
+    struct FieldOf {
+        const char* name;
+        M S::* member;
+    };
+
+    template<class S, class M>
+    constexpr FieldOf<S, M> Field(const char* name, M S::* member) {
+        return { name, member };
+    }
+
+    template<class T>
+    using IfReflected = std::void_t<decltype(Reflection<T>::fields)>;
+
+
+    template<class T, class = void>
     struct Native {
         inline static T From(const Napi::Value&);
     };
@@ -45,6 +75,12 @@ namespace DeskGap::JSNativeConvertion {
         }
     };
     template<>
+    struct Native<uint8_t> {
+        inline static uint8_t From(const Napi::Value& jsValue) {
+            return static_cast<uint8_t>(jsValue.As<Napi::Number>().Uint32Value());
+        }
+    };
+    template<>
     struct Native<bool> {
         inline static bool From(const Napi::Value& jsValue) {
             return jsValue.As<Napi::Boolean>().Value();
@@ -58,17 +94,56 @@ namespace DeskGap::JSNativeConvertion {
         }
     };
 
+    template<class E>
+    inline std::vector<E> NativeVectorFromArray(const Napi::Value& jsValue) {
+        Napi::Array jsArray = jsValue.As<Napi::Array>();
+        size_t arrayLength = jsArray.Length();
+        std::vector<E> result;
+        result.reserve(arrayLength);
+        for (size_t i = 0; i < arrayLength; i++) {
+            result.push_back(Native<E>::From(jsArray.Get(i)));
+        }
+        return result;
+    }
+
     template<class E>
     struct Native<std::vector<E>> {
         inline static std::vector<E> From(const Napi::Value& jsValue) {
-            Napi::Array jsArray = jsValue.As<Napi::Array>();
-            size_t arrayLength = jsArray.Length();
-            std::vector<E> result;
-            result.reserve(arrayLength);
-            for (size_t i = 0; i < arrayLength; i++) {
-                result.push_back(Native<E>::From(jsArray.Get(i)));
+            return NativeVectorFromArray<E>(jsValue);
+        }
+    };
+
+    // Buffers, typed arrays and ArrayBuffers are copied in one go, instead of one Get per element.
+    template<>
+    struct Native<std::vector<uint8_t>> {
+        inline static std::vector<uint8_t> From(const Napi::Value& jsValue) {
+            if (jsValue.IsArrayBuffer()) {
+                Napi::ArrayBuffer jsArrayBuffer = jsValue.As<Napi::ArrayBuffer>();
+                const uint8_t* bytes = static_cast<const uint8_t*>(jsArrayBuffer.Data());
+                return std::vector<uint8_t>(bytes, bytes + jsArrayBuffer.ByteLength());
+            }
+            if (jsValue.IsTypedArray()) {
+                Napi::TypedArray jsTypedArray = jsValue.As<Napi::TypedArray>();
+                const uint8_t* bytes = static_cast<const uint8_t*>(jsTypedArray.ArrayBuffer().Data()) + jsTypedArray.ByteOffset();
+                return std::vector<uint8_t>(bytes, bytes + jsTypedArray.ByteLength());
             }
-            return std::move(result);
+            if (jsValue.IsDataView()) {
+                Napi::DataView jsDataView = jsValue.As<Napi::DataView>();
+                const uint8_t* bytes = static_cast<const uint8_t*>(jsDataView.ArrayBuffer().Data()) + jsDataView.ByteOffset();
+                return std::vector<uint8_t>(bytes, bytes + jsDataView.ByteLength());
+            }
+            return NativeVectorFromArray<uint8_t>(jsValue);
+        }
+    };
+
+    template<>
+    struct Native<std::vector<double>> {
+        inline static std::vector<double> From(const Napi::Value& jsValue) {
+            if (jsValue.IsTypedArray() && jsValue.As<Napi::TypedArray>().TypedArrayType() == napi_float64_array) {
+                Napi::Float64Array jsArray = jsValue.As<Napi::Float64Array>();
+                return std::vector<double>(jsArray.Data(), jsArray.Data() + jsArray.ElementLength());
+            }
+            return NativeVectorFromArray<double>(jsValue);
         }
     };
 
@@ -78,10 +153,57 @@ namespace DeskGap::JSNativeConvertion {
     }
 
     template<class T>
+    struct Native<T, IfReflected<T>> {
+        inline static T From(const Napi::Value& jsValue) {
+            Napi::Object jsObject = jsValue.As<Napi::Object>();
+            T result;
+            std::apply([&](const auto&... fields) {
+                (ToNative(result.*(fields.member), jsObject.Get(fields.name)), ...);
+            }, Reflection<T>::fields);
+            return result;
+        }
+    };
+
+    template<class T, class = void>
     struct JS {
         inline static Napi::Value From(napi_env, const T&);
     };
 
+    template<class T>
+    inline Napi::Value JSFrom(napi_env env, T&& val) {
+        return JS<std::decay_t<T>>::From(env, std::forward<T>(val));
+    }
+
+    // Hands the memory of the vector over to an ArrayBuffer, whose finalizer frees it.
+    template<class E>
+    inline Napi::ArrayBuffer ExternalArrayBuffer(napi_env env, std::vector<E>&& values) {
+        auto ownedValues = new std::vector<E>(std::move(values));
+        return Napi::ArrayBuffer::New(
+            env, ownedValues->data(), ownedValues->size() * sizeof(E),
+            [](Napi::Env, void*, std::vector<E>* ownedValues) { delete ownedValues; },
+            ownedValues
+        );
+    }
+
+    template<>
+    struct JS<double> {
+        inline static Napi::Value From(napi_env env, double value) {
+            return Napi::Number::New(env, value);
+        }
+    };
+    template<>
+    struct JS<uint32_t> {
+        inline static Napi::Value From(napi_env env, uint32_t value) {
+            return Napi::Number::New(env, value);
+        }
+    };
+    template<>
+    struct JS<bool> {
+        inline static Napi::Value From(napi_env env, bool value) {
+            return Napi::Boolean::New(env, value);
+        }
+    };
+
     template<>
     struct JS<std::string> {
         inline static Napi::Value From(napi_env env,const std::string& utf8string) {
@@ -105,8 +227,60 @@ namespace DeskGap::JSNativeConvertion {
         }
     };
 
+    // Bytes become a Buffer. An rvalue is handed over without being copied.
+    template<>
+    struct JS<std::vector<uint8_t>> {
+        inline static Napi::Value From(napi_env env, const std::vector<uint8_t>& bytes) {
+            return Napi::Buffer<uint8_t>::Copy(env, bytes.data(), bytes.size());
+        }
+        inline static Napi::Value From(napi_env env, std::vector<uint8_t>&& bytes) {
+            // An empty vector may have no data to hand over
+            if (bytes.empty()) {
+                return Napi::Buffer<uint8_t>::New(env, 0);
+            }
+            auto ownedBytes = new std::vector<uint8_t>(std::move(bytes));
+            return Napi::Buffer<uint8_t>::New(
+                env, ownedBytes->data(), ownedBytes->size(),
+                [](Napi::Env, uint8_t*, std::vector<uint8_t>* ownedBytes) { delete ownedBytes; },
+                ownedBytes
+            );
+        }
+    };
+
+    // Numbers become a Float64Array. An rvalue is handed over without being copied.
+    template<>
+    struct JS<std::vector<double>> {
+        inline static Napi::Value From(napi_env env, const std::vector<double>& values) {
+            Napi::Float64Array array = Napi::Float64Array::New(env, values.size());
+            if (!values.empty()) {
+                std::memcpy(array.Data(), values.data(), values.size() * sizeof(double));
+            }
+            return array;
+        }
+        inline static Napi::Value From(napi_env env, std::vector<double>&& values) {
+            // An empty vector may have no data to hand over
+            if (values.empty()) {
+                return Napi::Float64Array::New(env, 0);
+            }
+            size_t length = values.size();
+            return Napi::Float64Array::New(env, length, ExternalArrayBuffer(env, std::move(values)), 0);
+        }
+    };
+
+    // All the fields are defined by one napi_define_properties call.
     template<class T>
-    inline Napi::Value JSFrom(napi_env env, T val) {
-        return JS<T>::From(env, val);
-    }
+    struct JS<T, IfReflected<T>> {
+        inline static Napi::Value From(napi_env env, const T& value) {
+            Napi::Object object = Napi::Object::New(env);
+            std::apply([&](const auto&... fields) {
+                object.DefineProperties({
+                    Napi::PropertyDescriptor::Value(
+                        fields.name, JSFrom(env, value.*(fields.member)),
+                        static_cast<napi_property_attributes>(napi_writable | napi_enumerable | napi_configurable)
+                    )...
+                });
+            }, Reflection<T>::fields);
+            return object;
+        }
+    };
 }
@@ -1,9 +1,12 @@
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <vector>
 
 #include "webview_wrap.h"
 #include <deskgap/webview.hpp>
 #include "../dispatch/dispatch.h"
+#include "../util/js_native_convert.h"
 
 extern "C" {
     extern char BIN2CODE_DG_UI_JS_CONTENT[];
@@ -15,16 +18,111 @@ extern "C" {
 }
 
 
+namespace {
+    int64_t NowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    template<class T>
+    void StoreMax(std::atomic<T>& maximum, T value) {
+        T current = maximum.load(std::memory_order_relaxed);
+        while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed));
+    }
+}
+
+namespace DeskGap {
+    struct MessageQueueStats {
+        double pendingMessages;
+        double pendingBytes;
+        double inFlightMessages;
+        double inFlightBytes;
+        double deliveredMessages;
+        double deliveredBatches;
+        double maxBufferedBytes;
+        double highWaterMark;
+    };
+
+    // Durations are in milliseconds
+    struct IpcStats {
+        double messagesToPage;
+        double bytesToPage;
+        double binaryMessagesToPage;
+        double binaryBytesToPage;
+        double batchesToPage;
+        double queueDepth;
+        double totalDeliveryLatency;
+        double maxDeliveryLatency;
+        double totalBatchBuildTime;
+        double messagesFromPage;
+        double bytesFromPage;
+        double binaryMessagesFromPage;
+        double binaryBytesFromPage;
+        double totalReceiveLatency;
+        double maxReceiveLatency;
+    };
+}
+
+namespace DeskGap::JSNativeConvertion {
+    template<>
+    struct Reflection<MessageQueueStats> {
+        static constexpr auto fields = std::make_tuple(
+            Field("pendingMessages", &MessageQueueStats::pendingMessages),
+            Field("pendingBytes", &MessageQueueStats::pendingBytes),
+            Field("inFlightMessages", &MessageQueueStats::inFlightMessages),
+            Field("inFlightBytes", &MessageQueueStats::inFlightBytes),
+            Field("deliveredMessages", &MessageQueueStats::deliveredMessages),
+            Field("deliveredBatches", &MessageQueueStats::deliveredBatches),
+            Field("maxBufferedBytes", &MessageQueueStats::maxBufferedBytes),
+            Field("highWaterMark", &MessageQueueStats::highWaterMark)
+        );
+    };
+
+    template<>
+    struct Reflection<IpcStats> {
+        static constexpr auto fields = std::make_tuple(
+            Field("messagesToPage", &IpcStats::messagesToPage),
+            Field("bytesToPage", &IpcStats::bytesToPage),
+            Field("binaryMessagesToPage", &IpcStats::binaryMessagesToPage),
+            Field("binaryBytesToPage", &IpcStats::binaryBytesToPage),
+            Field("batchesToPage", &IpcStats::batchesToPage),
+            Field("queueDepth", &IpcStats::queueDepth),
+            Field("totalDeliveryLatency", &IpcStats::totalDeliveryLatency),
+            Field("maxDeliveryLatency", &IpcStats::maxDeliveryLatency),
+            Field("totalBatchBuildTime", &IpcStats::totalBatchBuildTime),
+            Field("messagesFromPage", &IpcStats::messagesFromPage),
+            Field("bytesFromPage", &IpcStats::bytesFromPage),
+            Field("binaryMessagesFromPage", &IpcStats::binaryMessagesFromPage),
+            Field("binaryBytesFromPage", &IpcStats::binaryBytesFromPage),
+            Field("totalReceiveLatency", &IpcStats::totalReceiveLatency),
+            Field("maxReceiveLatency", &IpcStats::maxReceiveLatency)
+        );
+    };
+}
+
 namespace DeskGap {
     Napi::Function WebViewWrap::Constructor(const Napi::Env& env) {
         return DefineClass(env, "WebViewNative", {
         #ifdef WIN32
             StaticMethod("isWinRTEngineAvailable", &WebViewWrap::IsWinRTEngineAvailable),
             StaticMethod("getWebview2Version", &WebViewWrap::GetWebview2Version),
+        #endif
+        #ifdef __linux__
+            StaticMethod("setContextOptions", &WebViewWrap::SetContextOptions),
         #endif
             InstanceMethod("loadLocalFile", &WebViewWrap::LoadLocalFile),
             InstanceMethod("loadRequest", &WebViewWrap::LoadRequest),
             InstanceMethod("executeJavaScript", &WebViewWrap::ExecuteJavaScript),
+            InstanceMethod("queueMessage", &WebViewWrap::QueueMessage),
+            InstanceMethod("flushMessages", &WebViewWrap::FlushMessages),
+            InstanceMethod("setMessageQueueHighWaterMark", &WebViewWrap::SetMessageQueueHighWaterMark),
+            InstanceMethod("getMessageQueueStats", &WebViewWrap::GetMessageQueueStats),
+            InstanceMethod("getIpcStats", &WebViewWrap::GetIpcStats),
+        #ifdef __linux__
+            InstanceMethod("postBinaryMessage", &WebViewWrap::PostBinaryMessage),
+            InstanceMethod("setCrossOriginIsolated", &WebViewWrap::SetCrossOriginIsolated),
+        #endif
             InstanceMethod("reload", &WebViewWrap::Reload),
             InstanceMethod("setDevToolsEnabled", &WebViewWrap::SetDevToolsEnabled),
             InstanceMethod("destroy", &WebViewWrap::Destroy),
@@ -32,30 +130,70 @@ namespace DeskGap {
     }
 
     WebViewWrap::WebViewWrap(const Napi::CallbackInfo& info):
-            Napi::ObjectWrap<WebViewWrap>(info)
+            Napi::ObjectWrap<WebViewWrap>(info),
+            messageQueue_(std::make_shared<MessageQueue>()),
+            ipcCounters_(std::make_shared<IpcCounters>())
     {
         Napi::Object jsCallbacks = info[0].As<Napi::Object>();
+        events_ = EventTarget(info.Env(), {
+            jsCallbacks.Get("didFinishLoad").As<Napi::Function>(),
+            jsCallbacks.Get("onStringMessage").As<Napi::Function>(),
+            jsCallbacks.Get("onPageTitleUpdated").As<Napi::Function>(),
+            jsCallbacks.Get("onBinaryMessage").As<Napi::Function>(),
+            jsCallbacks.Get("onMessageQueueDrain").As<Napi::Function>()
+        });
+        messageQueue_->onDrain = events_.Sender(Event::MESSAGE_QUEUE_DRAIN);
 
         WebView::EventCallbacks eventCallbacks {
-            [jsDidFinishLoad = JSFunctionForUI::Persist(jsCallbacks.Get("didFinishLoad").As<Napi::Function>())]() {
-                jsDidFinishLoad->Call();
+            events_.Sender(Event::DID_FINISH_LOAD),
+        #ifndef __linux__
+            [onStringMessage = events_.Sender(Event::STRING_MESSAGE), ipcCounters = ipcCounters_](std::string&& stringMessage) {
+                ipcCounters->stringMessagesFromPage.fetch_add(1, std::memory_order_relaxed);
+                ipcCounters->stringBytesFromPage.fetch_add(stringMessage.size(), std::memory_order_relaxed);
+                onStringMessage(MakeEventPayload([stringMessage { std::move(stringMessage) }, ipcCounters, receivedAt = NowMicros()](napi_env env) -> napi_value {
+                    ipcCounters->RecordReceiveLatency(receivedAt);
+                    return Napi::String::New(env, stringMessage);
+                }));
             },
-            [jsOnStringMessage = JSFunctionForUI::Persist(jsCallbacks.Get("onStringMessage").As<Napi::Function>())](std::string&& stringMessage) {
-                jsOnStringMessage->Call([stringMessage { std::move(stringMessage) }](auto env) -> std::vector<napi_value> {
-                    return { Napi::String::New(env, stringMessage) };
-                });
+        #endif
+            [onPageTitleUpdated = events_.Sender(Event::PAGE_TITLE_UPDATED)](const std::string& title) {
+                onPageTitleUpdated(MakeEventPayload([title](napi_env env) -> napi_value {
+                    return Napi::String::New(env, title);
+                }));
             },
-            [jsOnPageTitleUpdated = JSFunctionForUI::Persist(jsCallbacks.Get("onPageTitleUpdated").As<Napi::Function>())](const std::string& title) {
-                jsOnPageTitleUpdated->Call([title](auto env) -> std::vector<napi_value> {
-                    return { Napi::String::New(env, title) };
-                });
+            [onBinaryMessage = events_.Sender(Event::BINARY_MESSAGE), ipcCounters = ipcCounters_](std::vector<uint8_t>&& binaryMessage) {
+                ipcCounters->binaryMessagesFromPage.fetch_add(1, std::memory_order_relaxed);
+                ipcCounters->binaryBytesFromPage.fetch_add(binaryMessage.size(), std::memory_order_relaxed);
+                onBinaryMessage(MakeEventPayload([binaryMessage { std::move(binaryMessage) }, ipcCounters, receivedAt = NowMicros()](napi_env env) mutable -> napi_value {
+                    ipcCounters->RecordReceiveLatency(receivedAt);
+                    // Hand the received bytes over to the Buffer instead of copying them.
+                    return JSNativeConvertion::JSFrom(env, std::move(binaryMessage));
+                }));
+            },
+        #ifdef __linux__
+            [onStringMessage = events_.Sender(Event::STRING_MESSAGE), ipcCounters = ipcCounters_](WebView::UTF16String&& stringMessage) {
+                ipcCounters->stringMessagesFromPage.fetch_add(1, std::memory_order_relaxed);
+                ipcCounters->stringBytesFromPage.fetch_add(stringMessage.length * sizeof(char16_t), std::memory_order_relaxed);
+                // The only conversion of the message: from the characters of the page's JS engine into a V8 string,
+                // which V8 stores in one byte per character if they are all Latin-1.
+                onStringMessage(MakeEventPayload([stringMessage { std::move(stringMessage) }, ipcCounters, receivedAt = NowMicros()](napi_env env) -> napi_value {
+                    ipcCounters->RecordReceiveLatency(receivedAt);
+                    return Napi::String::New(env, stringMessage.Characters(), stringMessage.length);
+                }));
             },
+        #endif
         };
 
     #ifdef WIN32
         Napi::Number engineValue = info[1].As<Napi::Number>();
         Engine engine = static_cast<Engine>(engineValue.Uint32Value());
     #endif
+    #ifdef __linux__
+        std::string partition;
+        if (Napi::Value jsPartition = info[2]; jsPartition.IsString()) {
+            partition = jsPartition.As<Napi::String>().Utf8Value();
+        }
+    #endif
 
         UISyncDelayable(info.Env(), [
             this,
@@ -63,6 +201,9 @@ namespace DeskGap {
         #ifdef WIN32
             , engine
         #endif
+        #ifdef __linux__
+            , partition = std::move(partition)
+        #endif
         ]() mutable {
             static std::string dgPreloadScript(BIN2CODE_DG_UI_JS_CONTENT, BIN2CODE_DG_UI_JS_SIZE);
         #ifdef WIN32
@@ -79,10 +220,19 @@ namespace DeskGap {
             else {
                 this->webview_ = std::make_unique<TridentWebView>(std::move(eventCallbacks), dgPreloadScriptWithPromise);
             }
+        #elif defined(__linux__)
+            this->webview_ = std::make_unique<WebView>(std::move(eventCallbacks), dgPreloadScript, partition);
         #else
             this->webview_ = std::make_unique<WebView>(std::move(eventCallbacks), dgPreloadScript);
         #endif
 
+            // Deliver the messages queued while the creation was delayed
+            this->messageQueue_->webView = this->webview_.get();
+            MessageQueue::DeliverPending(this->messageQueue_);
+        });
+        liveObject_ = LiveNativeObject(info.Env(), LiveNativeObjects::Kind::WEBVIEW, [this]() {
+            this->messageQueue_->webView = nullptr;
+            this->webview_.reset();
         });
     }
     
@@ -169,9 +319,176 @@ namespace DeskGap {
         });
     }
 
+    void WebViewWrap::MessageQueue::DeliverPending(const std::shared_ptr<MessageQueue>& queue) {
+        std::string script;
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            if (queue->webView == nullptr || queue->inFlightMessages > 0 || queue->pendingMessages.empty()) {
+                return;
+            }
+            int64_t buildStartedAt = NowMicros();
+            // The messages are JSON, so they are already valid expressions.
+            static const std::string scriptPrefix = "window.deskgap.__messagesReceived([";
+            script.reserve(scriptPrefix.size() + queue->pendingBytes + queue->pendingMessages.size() + 2);
+            script.append(scriptPrefix);
+            for (size_t i = 0; i < queue->pendingMessages.size(); ++i) {
+                if (i > 0) script.push_back(',');
+                script.append(queue->pendingMessages[i]);
+            }
+            script.append("])");
+
+            queue->inFlightMessages = queue->pendingMessages.size();
+            queue->inFlightBytes = queue->pendingBytes;
+            queue->inFlightQueuedAtSum = queue->pendingQueuedAtSum;
+            queue->oldestInFlightQueuedAt = queue->oldestPendingQueuedAt;
+            queue->pendingMessages.clear();
+            queue->pendingBytes = 0;
+            queue->pendingQueuedAtSum = 0;
+            queue->totalBatchBuildTime += NowMicros() - buildStartedAt;
+        }
+
+        queue->webView->ExecuteJavaScript(script, [queue](std::optional<std::string>&&) {
+            bool hasDrained = false;
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                int64_t deliveredAt = NowMicros();
+                queue->totalDeliveryLatency += static_cast<int64_t>(queue->inFlightMessages) * deliveredAt - queue->inFlightQueuedAtSum;
+                queue->maxDeliveryLatency = std::max<uint64_t>(queue->maxDeliveryLatency, deliveredAt - queue->oldestInFlightQueuedAt);
+                queue->deliveredMessages += queue->inFlightMessages;
+                queue->deliveredBatches++;
+                queue->inFlightMessages = 0;
+                queue->inFlightBytes = 0;
+                if (queue->needsDrain && queue->pendingBytes < queue->highWaterMark) {
+                    queue->needsDrain = false;
+                    hasDrained = true;
+                }
+            }
+            if (hasDrained) {
+                queue->onDrain();
+            }
+            // The messages queued while the page was busy go out in the next batch right away.
+            DeliverPending(queue);
+        });
+    }
+
+    Napi::Value WebViewWrap::QueueMessage(const Napi::CallbackInfo& info) {
+        std::string message = info[0].As<Napi::String>().Utf8Value();
+        int64_t queuedAt = NowMicros();
+        std::lock_guard<std::mutex> lock(messageQueue_->mutex);
+        if (messageQueue_->pendingMessages.empty()) {
+            messageQueue_->oldestPendingQueuedAt = queuedAt;
+        }
+        messageQueue_->pendingQueuedAtSum += queuedAt;
+        messageQueue_->pendingBytes += message.size();
+        messageQueue_->queuedMessages++;
+        messageQueue_->queuedBytes += message.size();
+        messageQueue_->pendingMessages.push_back(std::move(message));
+
+        size_t bufferedBytes = messageQueue_->pendingBytes + messageQueue_->inFlightBytes;
+        messageQueue_->maxBufferedBytes = std::max(messageQueue_->maxBufferedBytes, bufferedBytes);
+        if (bufferedBytes >= messageQueue_->highWaterMark) {
+            messageQueue_->needsDrain = true;
+        }
+        return Napi::Boolean::New(info.Env(), !messageQueue_->needsDrain);
+    }
+
+    void WebViewWrap::FlushMessages(const Napi::CallbackInfo& info) {
+        UIASync(info.Env(), [queue = messageQueue_]() {
+            MessageQueue::DeliverPending(queue);
+        });
+    }
+
+    void WebViewWrap::SetMessageQueueHighWaterMark(const Napi::CallbackInfo& info) {
+        std::lock_guard<std::mutex> lock(messageQueue_->mutex);
+        messageQueue_->highWaterMark = static_cast<size_t>(info[0].As<Napi::Number>().Int64Value());
+    }
+
+    Napi::Value WebViewWrap::GetMessageQueueStats(const Napi::CallbackInfo& info) {
+        MessageQueueStats stats;
+        {
+            std::lock_guard<std::mutex> lock(messageQueue_->mutex);
+            stats = {
+                static_cast<double>(messageQueue_->pendingMessages.size()),
+                static_cast<double>(messageQueue_->pendingBytes),
+                static_cast<double>(messageQueue_->inFlightMessages),
+                static_cast<double>(messageQueue_->inFlightBytes),
+                static_cast<double>(messageQueue_->deliveredMessages),
+                static_cast<double>(messageQueue_->deliveredBatches),
+                static_cast<double>(messageQueue_->maxBufferedBytes),
+                static_cast<double>(messageQueue_->highWaterMark),
+            };
+        }
+        return JSNativeConvertion::JSFrom(info.Env(), stats);
+    }
+
+    void WebViewWrap::IpcCounters::RecordReceiveLatency(int64_t receivedAt) {
+        uint64_t latency = NowMicros() - receivedAt;
+        totalReceiveLatency.fetch_add(latency, std::memory_order_relaxed);
+        StoreMax(maxReceiveLatency, latency);
+    }
+
+    Napi::Value WebViewWrap::GetIpcStats(const Napi::CallbackInfo& info) {
+        constexpr double kMicrosPerMilli = 1000;
+        IpcStats stats;
+        {
+            std::lock_guard<std::mutex> lock(messageQueue_->mutex);
+            stats.messagesToPage = messageQueue_->queuedMessages;
+            stats.bytesToPage = messageQueue_->queuedBytes;
+            stats.batchesToPage = messageQueue_->deliveredBatches;
+            stats.queueDepth = messageQueue_->pendingMessages.size() + messageQueue_->inFlightMessages;
+            stats.totalDeliveryLatency = messageQueue_->totalDeliveryLatency / kMicrosPerMilli;
+            stats.maxDeliveryLatency = messageQueue_->maxDeliveryLatency / kMicrosPerMilli;
+            stats.totalBatchBuildTime = messageQueue_->totalBatchBuildTime / kMicrosPerMilli;
+        }
+        stats.binaryMessagesToPage = ipcCounters_->binaryMessagesToPage.load(std::memory_order_relaxed);
+        stats.binaryBytesToPage = ipcCounters_->binaryBytesToPage.load(std::memory_order_relaxed);
+        stats.messagesFromPage = ipcCounters_->stringMessagesFromPage.load(std::memory_order_relaxed);
+        stats.bytesFromPage = ipcCounters_->stringBytesFromPage.load(std::memory_order_relaxed);
+        stats.binaryMessagesFromPage = ipcCounters_->binaryMessagesFromPage.load(std::memory_order_relaxed);
+        stats.binaryBytesFromPage = ipcCounters_->binaryBytesFromPage.load(std::memory_order_relaxed);
+        stats.totalReceiveLatency = ipcCounters_->totalReceiveLatency.load(std::memory_order_relaxed) / kMicrosPerMilli;
+        stats.maxReceiveLatency = ipcCounters_->maxReceiveLatency.load(std::memory_order_relaxed) / kMicrosPerMilli;
+        return JSNativeConvertion::JSFrom(info.Env(), stats);
+    }
+
+#ifdef __linux__
+    void WebViewWrap::PostBinaryMessage(const Napi::CallbackInfo& info) {
+        // Not read as an array of numbers, which any other object would be
+        if (!info[0].IsArrayBuffer() && !info[0].IsTypedArray() && !info[0].IsDataView()) {
+            throw Napi::TypeError::New(info.Env(), "The data must be an ArrayBuffer or an ArrayBufferView");
+        }
+        std::vector<uint8_t> data = JSNativeConvertion::Native<std::vector<uint8_t>>::From(info[0]);
+        ipcCounters_->binaryMessagesToPage.fetch_add(1, std::memory_order_relaxed);
+        ipcCounters_->binaryBytesToPage.fetch_add(data.size(), std::memory_order_relaxed);
+
+        UISyncDelayable(info.Env(), [this, data { std::move(data) }]() mutable {
+            this->webview_->PostBinaryMessage(std::move(data));
+        });
+    }
+
+    void WebViewWrap::SetCrossOriginIsolated(const Napi::CallbackInfo& info) {
+        bool isolated = info[0].As<Napi::Boolean>().Value();
+        UISyncDelayable(info.Env(), [this, isolated]() {
+            this->webview_->SetCrossOriginIsolated(isolated);
+        });
+    }
+
+    void WebViewWrap::SetContextOptions(const Napi::CallbackInfo& info) {
+        WebView::ContextOptions options;
+        options.cacheModel = static_cast<WebView::ContextOptions::CacheModel>(info[0].As<Napi::Number>().Uint32Value());
+        options.webProcessCountLimit = info[1].As<Napi::Number>().Uint32Value();
+        UISyncDelayable(info.Env(), [options]() {
+            WebView::SetContextOptions(options);
+        });
+    }
+#endif
+
     void WebViewWrap::Destroy(const Napi::CallbackInfo& info) {
         UISyncDelayable(info.Env(), [this]() {
+            this->messageQueue_->webView = nullptr;
             this->webview_.reset();
         });
+        events_.Remove();
+        liveObject_.Remove();
     }
 }
@@ -2,18 +2,96 @@
 #define webview_webview_wrap_h
 
 #include <napi.h>
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include <deskgap/webview.hpp>
+#include "../dispatch/event_channel.h"
+#include "../live_native_objects.h"
 
 namespace DeskGap {
     class WebViewWrap: public Napi::ObjectWrap<WebViewWrap> {
     private:
         friend class BrowserWindowWrap;
         std::unique_ptr<WebView> webview_;
+
+        // The types of the events in events_, in the order of the handlers
+        enum class Event: uint32_t {
+            DID_FINISH_LOAD = 0, STRING_MESSAGE = 1, PAGE_TITLE_UPDATED = 2, BINARY_MESSAGE = 3, MESSAGE_QUEUE_DRAIN = 4
+        };
+        EventTarget events_;
+        // Destroys the native object if the env of a worker is torn down before it is destroyed
+        LiveNativeObject liveObject_;
+
+        // Messages to the page are joined into one script per delivery, and only one delivery is in flight at a time,
+        // so a page that is slow to run them gets larger batches instead of a backlog of scripts.
+        struct MessageQueue {
+            std::mutex mutex;
+            std::vector<std::string> pendingMessages;
+            size_t pendingBytes = 0;
+            size_t inFlightMessages = 0;
+            size_t inFlightBytes = 0;
+            size_t highWaterMark = 1 << 20;
+            bool needsDrain = false;
+
+            uint64_t deliveredMessages = 0;
+            uint64_t deliveredBatches = 0;
+            size_t maxBufferedBytes = 0;
+
+            uint64_t queuedMessages = 0;
+            uint64_t queuedBytes = 0;
+            // Sums of the times (in microseconds) the messages were queued at,
+            // so the total delivery latency is known without keeping a timestamp per message.
+            int64_t pendingQueuedAtSum = 0;
+            int64_t inFlightQueuedAtSum = 0;
+            int64_t oldestPendingQueuedAt = 0;
+            int64_t oldestInFlightQueuedAt = 0;
+            uint64_t totalDeliveryLatency = 0;
+            uint64_t maxDeliveryLatency = 0;
+            uint64_t totalBatchBuildTime = 0;
+
+            // Only accessed on the UI thread
+            WebView* webView = nullptr;
+            std::function<void()> onDrain;
+
+            static void DeliverPending(const std::shared_ptr<MessageQueue>& queue);
+        };
+        std::shared_ptr<MessageQueue> messageQueue_;
+
+        // Updated on the UI thread as messages arrive, and on the Node thread as they are converted to JS values.
+        // Durations are in microseconds.
+        struct IpcCounters {
+            std::atomic<uint64_t> stringMessagesFromPage { 0 };
+            std::atomic<uint64_t> stringBytesFromPage { 0 };
+            std::atomic<uint64_t> binaryMessagesFromPage { 0 };
+            std::atomic<uint64_t> binaryBytesFromPage { 0 };
+            std::atomic<uint64_t> binaryMessagesToPage { 0 };
+            std::atomic<uint64_t> binaryBytesToPage { 0 };
+            // From the UI thread receiving a message to the Node thread converting it
+            std::atomic<uint64_t> totalReceiveLatency { 0 };
+            std::atomic<uint64_t> maxReceiveLatency { 0 };
+
+            void RecordReceiveLatency(int64_t receivedAt);
+        };
+        std::shared_ptr<IpcCounters> ipcCounters_;
+
         void LoadLocalFile(const Napi::CallbackInfo& info);
         void LoadRequest(const Napi::CallbackInfo& info);
         void ExecuteJavaScript(const Napi::CallbackInfo& info);
+        Napi::Value QueueMessage(const Napi::CallbackInfo& info);
+        void FlushMessages(const Napi::CallbackInfo& info);
+        void SetMessageQueueHighWaterMark(const Napi::CallbackInfo& info);
+        Napi::Value GetMessageQueueStats(const Napi::CallbackInfo& info);
+        Napi::Value GetIpcStats(const Napi::CallbackInfo& info);
+        #ifdef __linux__
+        void PostBinaryMessage(const Napi::CallbackInfo& info);
+        void SetCrossOriginIsolated(const Napi::CallbackInfo& info);
+        static void SetContextOptions(const Napi::CallbackInfo& info);
+        #endif
         void Reload(const Napi::CallbackInfo&);
         void SetDevToolsEnabled(const Napi::CallbackInfo& info);
         void Destroy(const Napi::CallbackInfo& info);
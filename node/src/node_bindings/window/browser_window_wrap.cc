@@ -6,8 +6,17 @@
 #include "../dispatch/dispatch.h"
 
 namespace DeskGap {
+    namespace {
+        Napi::Value PairToJS(napi_env env, const std::array<int, 2>& pair) {
+            Napi::Array jsPair = Napi::Array::New(env, 2);
+            jsPair.Set((uint32_t)0, Napi::Number::New(env, pair[0]));
+            jsPair.Set((uint32_t)1, Napi::Number::New(env, pair[1]));
+            return jsPair;
+        }
+    }
+
     void BrowserWindowWrap::Show(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this]() {
+        UICommand(info.Env(), { Value() }, [this]() {
             this->browser_window_->Show();
         });
     }
@@ -16,7 +25,7 @@ namespace DeskGap {
         int height = info[1].As<Napi::Number>();
         bool animate = info[2].As<Napi::Boolean>();
 
-        UISyncDelayable(info.Env(), [
+        UICommand(info.Env(), { Value() }, [
             this, width, height, animate
         ] {
             this->browser_window_->SetSize(width, height, animate);
@@ -28,7 +37,7 @@ namespace DeskGap {
         int y = info[1].As<Napi::Number>();
         bool animate = info[2].As<Napi::Boolean>();
 
-        UISyncDelayable(info.Env(), [
+        UICommand(info.Env(), { Value() }, [
             this, x, y, animate
         ] {
             this->browser_window_->SetPosition(x, y, animate);
@@ -39,7 +48,7 @@ namespace DeskGap {
         int width = info[0].As<Napi::Number>();
         int height = info[1].As<Napi::Number>();
 
-        UISyncDelayable(info.Env(), [this, width, height] {
+        UICommand(info.Env(), { Value() }, [this, width, height] {
             this->browser_window_->SetMaximumSize(width, height);
         });
     }
@@ -48,41 +57,85 @@ namespace DeskGap {
         int width = info[0].As<Napi::Number>();
         int height = info[1].As<Napi::Number>();
 
-        UISyncDelayable(info.Env(), [this, width, height] {
+        UICommand(info.Env(), { Value() }, [this, width, height] {
             this->browser_window_->SetMinimumSize(width, height);
         });
     }
 
     void BrowserWindowWrap::SetTitle(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this, utf8title = info[0].As<Napi::String>().Utf8Value()] {
+        UICommand(info.Env(), { Value() }, [this, utf8title = info[0].As<Napi::String>().Utf8Value()] {
             this->browser_window_->SetTitle(utf8title);
         });
     }
 
     Napi::Value BrowserWindowWrap::GetSize(const Napi::CallbackInfo& info) {
+    #ifdef __linux__
+        WaitForUICommands(info.Env());
+        // Null while the construction is delayed by bulkUISync
+        if (browser_window_ != nullptr) {
+            BrowserWindow::State state = browser_window_->GetState();
+            return PairToJS(info.Env(), { state.width, state.height });
+        }
+    #endif
         std::array<int, 2> size;
         UISync(info.Env(), [this, &size]() {
             size = this->browser_window_->GetSize();
         });
-        Napi::Array jsSize = Napi::Array::New(info.Env(), 2);
-        jsSize.Set((uint32_t)0, Napi::Number::New(info.Env(), size[0]));
-        jsSize.Set((uint32_t)1, Napi::Number::New(info.Env(), size[1]));
-        return jsSize;
+        return PairToJS(info.Env(), size);
     }
 
     Napi::Value BrowserWindowWrap::GetPosition(const Napi::CallbackInfo& info) {
+    #ifdef __linux__
+        WaitForUICommands(info.Env());
+        if (browser_window_ != nullptr) {
+            BrowserWindow::State state = browser_window_->GetState();
+            return PairToJS(info.Env(), { state.x, state.y });
+        }
+    #endif
         std::array<int, 2> position;
         UISync(info.Env(), [this, &position]() {
             position = this->browser_window_->GetPosition();
         });
-        Napi::Array jsPosition = Napi::Array::New(info.Env(), 2);
-        jsPosition.Set((uint32_t)0, Napi::Number::New(info.Env(), position[0]));
-        jsPosition.Set((uint32_t)1, Napi::Number::New(info.Env(), position[1]));
-        return jsPosition;
+        return PairToJS(info.Env(), position);
+    }
+
+    Napi::Value BrowserWindowWrap::GetSizeAsync(const Napi::CallbackInfo& info) {
+        return UIPromise(info.Env(), { Value() }, [this]() -> JSValueGetter {
+            return [size = this->browser_window_->GetSize()](napi_env env) {
+                return PairToJS(env, size);
+            };
+        });
+    }
+
+    Napi::Value BrowserWindowWrap::GetPositionAsync(const Napi::CallbackInfo& info) {
+        return UIPromise(info.Env(), { Value() }, [this]() -> JSValueGetter {
+            return [position = this->browser_window_->GetPosition()](napi_env env) {
+                return PairToJS(env, position);
+            };
+        });
+    }
+
+#ifdef __linux__
+    Napi::Value BrowserWindowWrap::IsFocused(const Napi::CallbackInfo& info) {
+        WaitForUICommands(info.Env());
+        if (browser_window_ == nullptr) {
+            return Napi::Boolean::New(info.Env(), false);
+        }
+        return Napi::Boolean::New(info.Env(), browser_window_->GetState().focused);
     }
 
+    Napi::Value BrowserWindowWrap::IsFocusedAsync(const Napi::CallbackInfo& info) {
+        return UIPromise(info.Env(), { Value() }, [this]() -> JSValueGetter {
+            bool focused = this->browser_window_ != nullptr && this->browser_window_->GetState().focused;
+            return [focused](napi_env env) -> napi_value {
+                return Napi::Boolean::New(env, focused);
+            };
+        });
+    }
+#endif
+
     void BrowserWindowWrap::Center(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this] {
+        UICommand(info.Env(), { Value() }, [this] {
             this->browser_window_->Center();
         });
     }
@@ -92,10 +145,12 @@ namespace DeskGap {
             this->browser_window_->Destroy();
             this->browser_window_.reset();
         });
+        events_.Remove();
+        liveObject_.Remove();
     }
 
     void BrowserWindowWrap::Close(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this] { this->browser_window_->Close(); });
+        UICommand(info.Env(), { Value() }, [this] { this->browser_window_->Close(); });
     }
 
     void BrowserWindowWrap::PopupMenu(const Napi::CallbackInfo& info) {
@@ -126,9 +181,15 @@ namespace DeskGap {
         if (!info[0].IsNull()) {
             menuWrap = MenuWrap::Unwrap(info[0].As<Napi::Object>());
         }
-        UISyncDelayable(info.Env(), [this, menuWrap] {
+        auto setMenu = [this, menuWrap] {
             this->browser_window_->SetMenu((menuWrap == nullptr) ? nullptr: menuWrap->menu_.get());
-        });
+        };
+        if (menuWrap == nullptr) {
+            UICommand(info.Env(), { Value() }, std::move(setMenu));
+        }
+        else {
+            UICommand(info.Env(), { Value(), menuWrap->Value() }, std::move(setMenu));
+        }
     }
     void BrowserWindowWrap::SetIcon(const Napi::CallbackInfo& info) {
         Napi::Value jsIconPath = info[0];
@@ -136,7 +197,7 @@ namespace DeskGap {
         if (!jsIconPath.IsNull()) {
             iconPath = jsIconPath.As<Napi::String>().Utf8Value();
         }
-        UISyncDelayable(info.Env(), [this, iconPath] {
+        UICommand(info.Env(), { Value() }, [this, iconPath] {
             this->browser_window_->SetIcon(iconPath);
         });
     }
@@ -145,7 +206,7 @@ namespace DeskGap {
 #ifdef __APPLE__
     void BrowserWindowWrap::SetTitleBarStyle(const Napi::CallbackInfo& info) {
         auto titleBarStyle = static_cast<BrowserWindow::TitleBarStyle>(info[0].As<Napi::Number>().Int32Value());
-        UISyncDelayable(info.Env(), [this, titleBarStyle] {
+        UICommand(info.Env(), { Value() }, [this, titleBarStyle] {
             this->browser_window_->SetTitleBarStyle(titleBarStyle);
         });
     }
@@ -184,40 +245,40 @@ namespace DeskGap {
             vibrancies.push_back(v);
         }
 
-        UISyncDelayable(info.Env(), [this, vibrancies] {
+        UICommand(info.Env(), { Value() }, [this, vibrancies] {
             this->browser_window_->SetVibrancies(vibrancies);
         });
     }
 #endif
 
     void BrowserWindowWrap::SetMaximizable(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this, maximizable = info[0].As<Napi::Boolean>().Value()] {
+        UICommand(info.Env(), { Value() }, [this, maximizable = info[0].As<Napi::Boolean>().Value()] {
             this->browser_window_->SetMaximizable(maximizable);
         });
     }
     void BrowserWindowWrap::SetMinimizable(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this, minimizable = info[0].As<Napi::Boolean>().Value()] {
+        UICommand(info.Env(), { Value() }, [this, minimizable = info[0].As<Napi::Boolean>().Value()] {
             this->browser_window_->SetMinimizable(minimizable);
         });
     }
     void BrowserWindowWrap::SetResizable(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this, resizable = info[0].As<Napi::Boolean>().Value()] {
+        UICommand(info.Env(), { Value() }, [this, resizable = info[0].As<Napi::Boolean>().Value()] {
             this->browser_window_->SetResizable(resizable);
         });
     }
     void BrowserWindowWrap::SetHasFrame(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this, hasFrame = info[0].As<Napi::Boolean>().Value()] {
+        UICommand(info.Env(), { Value() }, [this, hasFrame = info[0].As<Napi::Boolean>().Value()] {
             this->browser_window_->SetHasFrame(hasFrame);
         });
     }
     void BrowserWindowWrap::SetClosable(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this, closable = info[0].As<Napi::Boolean>().Value()] {
+        UICommand(info.Env(), { Value() }, [this, closable = info[0].As<Napi::Boolean>().Value()] {
             this->browser_window_->SetClosable(closable);
         });
     }
 
     void BrowserWindowWrap::Minimize(const Napi::CallbackInfo& info) {
-        UISyncDelayable(info.Env(), [this] {
+        UICommand(info.Env(), { Value() }, [this] {
             this->browser_window_->Minimize();
         });
     }
@@ -228,22 +289,20 @@ namespace DeskGap {
         WebViewWrap* webViewWrap = WebViewWrap::Unwrap(info[0].As<Napi::Object>());
         Napi::Object jsCallbacks = info[1].As<Napi::Object>();
 
+        events_ = EventTarget(info.Env(), {
+            jsCallbacks.Get("onBlur").As<Napi::Function>(),
+            jsCallbacks.Get("onFocus").As<Napi::Function>(),
+            jsCallbacks.Get("onResize").As<Napi::Function>(),
+            jsCallbacks.Get("onMove").As<Napi::Function>(),
+            jsCallbacks.Get("onClose").As<Napi::Function>()
+        });
+
         BrowserWindow::EventCallbacks callbacks {
-            [jsOnBlur = JSFunctionForUI::Persist(jsCallbacks.Get("onBlur").As<Napi::Function>())]() {
-                jsOnBlur->Call();
-            },
-            [jsOnFocus = JSFunctionForUI::Persist(jsCallbacks.Get("onFocus").As<Napi::Function>())]() {
-                jsOnFocus->Call();
-            },
-            [jsOnResize = JSFunctionForUI::Persist(jsCallbacks.Get("onResize").As<Napi::Function>())]() {
-                jsOnResize->Call();
-            },
-            [jsOnMove = JSFunctionForUI::Persist(jsCallbacks.Get("onMove").As<Napi::Function>())]() {
-                jsOnMove->Call();
-            },
-            [jsOnClose = JSFunctionForUI::Persist(jsCallbacks.Get("onClose").As<Napi::Function>())]() {
-                jsOnClose->Call();
-            }
+            events_.Sender(Event::BLUR),
+            events_.Sender(Event::FOCUS),
+            events_.Sender(Event::RESIZE),
+            events_.Sender(Event::MOVE),
+            events_.Sender(Event::CLOSE)
 #ifdef __APPLE__
             //TODO: Export fullscreen events to js
             ,[]() {}, [](){}, [](){}, [](){}
@@ -252,6 +311,12 @@ namespace DeskGap {
         UISyncDelayable(info.Env(), [this, webViewWrap, callbacks = std::move(callbacks)]() mutable {
             this->browser_window_ = std::make_unique<BrowserWindow>(*(webViewWrap->webview_), std::move(callbacks));
         });
+        liveObject_ = LiveNativeObject(info.Env(), LiveNativeObjects::Kind::WINDOW, [this] {
+            if (this->browser_window_ != nullptr) {
+                this->browser_window_->Destroy();
+                this->browser_window_.reset();
+            }
+        });
     }
     Napi::Function BrowserWindowWrap::Constructor(Napi::Env env) {
         return DefineClass(env, "BrowserWindowNative", {
@@ -264,8 +329,14 @@ namespace DeskGap {
             InstanceMethod("center", &BrowserWindowWrap::Center),
             InstanceMethod("getPosition", &BrowserWindowWrap::GetPosition),
             InstanceMethod("getSize", &BrowserWindowWrap::GetSize),
+            InstanceMethod("getPositionAsync", &BrowserWindowWrap::GetPositionAsync),
+            InstanceMethod("getSizeAsync", &BrowserWindowWrap::GetSizeAsync),
             InstanceMethod("destroy", &BrowserWindowWrap::Destroy),
             InstanceMethod("close", &BrowserWindowWrap::Close),
+        #ifdef __linux__
+            InstanceMethod("isFocused", &BrowserWindowWrap::IsFocused),
+            InstanceMethod("isFocusedAsync", &BrowserWindowWrap::IsFocusedAsync),
+        #endif
         #ifndef __APPLE__
             InstanceMethod("setMenu", &BrowserWindowWrap::SetMenu),
             InstanceMethod("setIcon", &BrowserWindowWrap::SetIcon),
@@ -4,11 +4,22 @@
 #include <napi.h>
 #include <functional>
 #include <deskgap/browser_window.hpp>
+#include "../dispatch/event_channel.h"
+#include "../live_native_objects.h"
 
 namespace DeskGap {
     class BrowserWindowWrap: public Napi::ObjectWrap<BrowserWindowWrap> {
     private:
         std::unique_ptr<BrowserWindow> browser_window_;
+
+        // The types of the events in events_, in the order of the handlers
+        enum class Event: uint32_t {
+            BLUR = 0, FOCUS = 1, RESIZE = 2, MOVE = 3, CLOSE = 4
+        };
+        EventTarget events_;
+        // Destroys the native object if the env of a worker is torn down before it is destroyed
+        LiveNativeObject liveObject_;
+
         void Show(const Napi::CallbackInfo& info);
         void SetSize(const Napi::CallbackInfo& info);
         void SetPosition(const Napi::CallbackInfo& info);
@@ -17,6 +28,12 @@ namespace DeskGap {
         void SetTitle(const Napi::CallbackInfo& info);
         Napi::Value GetSize(const Napi::CallbackInfo& info);
         Napi::Value GetPosition(const Napi::CallbackInfo& info);
+        Napi::Value GetSizeAsync(const Napi::CallbackInfo& info);
+        Napi::Value GetPositionAsync(const Napi::CallbackInfo& info);
+    #ifdef __linux__
+        Napi::Value IsFocused(const Napi::CallbackInfo& info);
+        Napi::Value IsFocusedAsync(const Napi::CallbackInfo& info);
+    #endif
         void Center(const Napi::CallbackInfo& info);
         void Destroy(const Napi::CallbackInfo& info);
         void Close(const Napi::CallbackInfo& info);
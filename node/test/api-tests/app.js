@@ -1,7 +1,9 @@
-const { app } = require('deskgap');
+const { app, BrowserWindow, Worker } = require('deskgap');
+const { once } = require('events');
 const chai = require('chai');
-const { spawnDeskGapAppAsync } = require('../utils');
+const { spawnDeskGapAppAsync, spawnDeskGapAppWithEnvAsync } = require('../utils');
 const fs = require('fs');
+const path = require('path');
 
 const { expect } = chai;
 
@@ -24,6 +26,32 @@ describe('process', () => {
     });
 });
 
+describe('options of the embedded Node', () => {
+    const printAndExit = (expression) => `
+        const { app } = require('deskgap');
+        process.stdout.write(String(${expression}));
+        app.exit();
+    `;
+
+    it('reports an invalid DESKGAP_PLATFORM_WORKER_THREADS and starts with the default', async () => {
+        for (const threads of ['2.5', '0', '4 threads']) {
+            const result = await spawnDeskGapAppWithEnvAsync('arbitrary-code', {
+                'DESKGAP_PLATFORM_WORKER_THREADS': threads
+            }, printAndExit("'started'"));
+            expect(result.stdout).to.equal('started');
+            expect(result.stderr).to.contain('DeskGap: ignored an invalid option: DESKGAP_PLATFORM_WORKER_THREADS: Expected an integer between 1 and 1024');
+        }
+    });
+
+    it('sets the valid V8 flags and reports the unknown ones instead of failing to start', async () => {
+        const result = await spawnDeskGapAppWithEnvAsync('arbitrary-code', {
+            'DESKGAP_V8_FLAGS': '--no-such-v8-flag --expose-gc'
+        }, printAndExit('typeof gc'));
+        expect(result.stdout).to.equal('function');
+        expect(result.stderr).to.contain('DeskGap: ignored an invalid option: V8 flag --no-such-v8-flag');
+    });
+});
+
 describe('app module', () => {
     describe('app.getVersion', () => {
         it('returns the version field of package.json', () => {
@@ -60,6 +88,108 @@ describe('app module', () => {
         })
     });
 
+    describe('app.getUIDispatchStats()', () => {
+        it('runs the actions of concurrent threads and accounts for each of them', async function() {
+            if (process.platform !== 'linux') return this.skip();
+            const count = 200;
+            const before = app.getUIDispatchStats();
+
+            const worker = new Worker(path.resolve(__dirname, '..', 'fixtures', 'modules', 'worker-ui-getters.js'), { workerData: { count } });
+            const win = new BrowserWindow({ show: false });
+            let matched = 0;
+            let workerMatched;
+            try {
+                win.setTitle('main');
+                for (let i = 0; i < count; i++) {
+                    if (win.getTitle() === 'main') matched++;
+                }
+                [workerMatched] = await once(worker, 'message');
+            }
+            finally {
+                win.destroy();
+                await worker.terminate();
+            }
+            expect(matched).to.equal(count);
+            expect(workerMatched).to.equal(count);
+
+            const after = app.getUIDispatchStats();
+            const dispatched = after.dispatchedActions - before.dispatchedActions;
+            expect(dispatched).to.be.at.least(2 * count);
+            // A wakeup drains every action queued until then
+            expect(after.wakeups - before.wakeups).to.be.within(1, dispatched);
+            expect(after.queueDepth).to.equal(0);
+            expect(after.maxQueueDepth).to.be.at.least(1);
+            expect(after.totalLatencyMicroseconds).to.be.at.least(after.maxLatencyMicroseconds);
+        });
+    });
+
+    describe('app.getStartupMetrics()', () => {
+        it('returns the startup phases of the main thread', () => {
+            const phases = app.getStartupMetrics().phases;
+            for (const name of ['bundleEval', 'appEntry']) {
+                const phase = phases.find(p => p.name === name);
+                expect(phase).to.include({ thread: 'node' });
+                expect(phase.duration).to.be.at.least(0);
+            }
+        });
+
+        it('does not record the phases of a worker', async () => {
+            const eventCount = app.getStartupTrace().traceEvents.length;
+            const worker = new Worker(path.resolve(__dirname, '..', 'fixtures', 'modules', 'worker-browser-window.js'));
+            try {
+                const [message] = await once(worker, 'message');
+                expect(message).to.equal('loaded');
+            }
+            finally {
+                await worker.terminate();
+            }
+            expect(app.getStartupTrace().traceEvents.length).to.equal(eventCount);
+        });
+
+        describe('DESKGAP_STARTUP_TRACE', () => {
+            const blankPagePath = path.resolve(__dirname, '..', 'fixtures', 'files', 'blank.html');
+            const showAndLoad = (onLoaded) => `
+                const { app, BrowserWindow } = require('deskgap');
+                app.whenReady().then(() => {
+                    const win = new BrowserWindow();
+                    win.webView.once('did-finish-load', () => { ${onLoaded} });
+                    win.loadFile(${JSON.stringify(blankPagePath)});
+                });
+            `;
+
+            it('writes the trace once the first window is shown and loaded', async () => {
+                const dir = fs.mkdtempSync(path.join(require('os').tmpdir(), 'deskgap-startup-trace-'));
+                try {
+                    const traceFilePath = path.join(dir, 'trace.json');
+                    const result = await spawnDeskGapAppWithEnvAsync('arbitrary-code', {
+                        'DESKGAP_STARTUP_TRACE': traceFilePath
+                    }, showAndLoad(`
+                        process.stdout.write(String(require('fs').existsSync(${JSON.stringify(traceFilePath)})));
+                        app.exit();
+                    `));
+                    expect(result.stdout).to.equal('true');
+                    const names = JSON.parse(fs.readFileSync(traceFilePath, 'utf8')).traceEvents.map(event => event.name);
+                    expect(names).to.include.members(['ready', 'firstBrowserWindow', 'firstShow', 'firstDidFinishLoad']);
+                }
+                finally {
+                    fs.rmSync(dir, { recursive: true, force: true });
+                }
+            });
+
+            it('reports a trace file that cannot be written as a warning', async () => {
+                const traceFilePath = path.join(__dirname, 'no-such-directory', 'trace.json');
+                const result = await spawnDeskGapAppWithEnvAsync('arbitrary-code', {
+                    'DESKGAP_STARTUP_TRACE': traceFilePath
+                }, showAndLoad(`
+                    process.stdout.write('loaded');
+                    setImmediate(() => app.exit());
+                `));
+                expect(result.stdout).to.equal('loaded');
+                expect(result.stderr).to.contain(`Failed to write the startup trace to ${traceFilePath}`);
+            });
+        });
+    });
+
     describe('app.exit(code)', () => {
         it('emits a process exit event with the code', async () => {
             const error = await spawnDeskGapAppAsync('arbitrary-code', `
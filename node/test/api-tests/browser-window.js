@@ -1,4 +1,4 @@
-const { app, BrowserWindow } = require('deskgap');
+const { app, BrowserWindow, Menu } = require('deskgap');
 const chai = require('chai');
 const path = require('path');
 
@@ -48,6 +48,52 @@ describe('BrowserWindow module', () => {
             expect(win.isDestroyed()).to.equal(true);
         })
     });
+    for (const nonBlocking of [false, true]) {
+        describe(`getters with app.setNonBlockingUIGetters(${nonBlocking})`, () => {
+            before(() => {
+                app.setNonBlockingUIGetters(nonBlocking);
+            });
+            after(() => {
+                app.setNonBlockingUIGetters(false);
+            });
+
+            it('reads the position of a centered window instead of a placeholder', async () => {
+                const win = new BrowserWindow({ show: false, center: false, x: 10, y: 20 });
+                try {
+                    win.center();
+                    const position = win.getPosition();
+                    expect(position).to.eql(await win.getPositionAsync());
+                    expect(win.getPosition()).to.eql(position);
+                }
+                finally {
+                    win.destroy();
+                }
+            });
+            it('keeps the position set after an earlier getPositionAsync', async () => {
+                const win = new BrowserWindow({ show: false, center: true });
+                try {
+                    const pending = win.getPositionAsync();
+                    win.setPosition(30, 40);
+                    await pending;
+                    expect(win.getPosition()).to.eql(await win.getPositionAsync());
+                }
+                finally {
+                    win.destroy();
+                }
+            });
+            it('resolves isFocusedAsync() and getTitleAsync() like their sync variants', async () => {
+                const win = new BrowserWindow({ show: false, title: 'Async Title' });
+                try {
+                    expect(await win.getTitleAsync()).to.equal('Async Title');
+                    expect(await win.getTitleAsync()).to.equal(win.getTitle());
+                    expect(await win.isFocusedAsync()).to.equal(win.isFocused());
+                }
+                finally {
+                    win.destroy();
+                }
+            });
+        });
+    }
     describe('win.setMenu(menu)', () => {
         it('should not throw when it is called after the window has been shown', function () {
             if (mac) return this.skip();
@@ -62,6 +108,160 @@ describe('BrowserWindow module', () => {
             win.show();
             win.destroy();
         });
+        it('builds large nested menus and updates their items', function () {
+            if (mac) return this.skip();
+            const menu = Menu.buildFromTemplate([{
+                label: 'Files',
+                submenu: Array.from({ length: 2000 }, (_, i) => ({ label: `File ${i}`, accelerator: i === 0 ? 'CmdOrCtrl+O' : '' }))
+            }, {
+                label: 'View',
+                submenu: [{ label: 'Wrap', type: 'checkbox' }, { type: 'separator' }, { label: 'Recent', submenu: [] }]
+            }]);
+            const win = new BrowserWindow({ show: false });
+            win.setMenu(menu);
+            const wrapItem = menu.items[1].submenu.items[0];
+            wrapItem.checked = true;
+            wrapItem.enabled = false;
+            expect(wrapItem.checked).to.equal(true);
+            win.setMenu(null);
+            win.destroy();
+        });
+        it('updates a shown menu in place', function () {
+            if (mac) return this.skip();
+            const template = (labels, checked) => [{
+                label: 'Edit',
+                submenu: labels.map((label) => ({ id: label, label, accelerator: label === 'Undo' ? 'CmdOrCtrl+Z' : '' }))
+            }, {
+                label: 'View',
+                submenu: [{ label: 'Wrap', type: 'checkbox', checked }]
+            }];
+            const menu = Menu.buildFromTemplate(template(['Undo', 'Cut', 'Copy'], false));
+            const win = new BrowserWindow({ show: false });
+            win.setMenu(menu);
+            const [editItem, viewItem] = menu.items;
+            const undoItem = editItem.submenu.items[0];
+
+            menu.update(template(['Paste', 'Undo', 'Copy'], true));
+            expect(menu.items[0]).to.equal(editItem);
+            expect(menu.items[1]).to.equal(viewItem);
+            expect(editItem.submenu.items.map(item => item.label)).to.deep.equal(['Paste', 'Undo', 'Copy']);
+            expect(editItem.submenu.items[1]).to.equal(undoItem);
+            expect(viewItem.submenu.items[0].checked).to.equal(true);
+            win.setMenu(null);
+            win.destroy();
+        });
+        it('does not fill lazy submenus until they are shown', function () {
+            if (mac) return this.skip();
+            let providerCalls = 0;
+            const menu = Menu.buildFromTemplate([{
+                label: 'History',
+                submenu: () => {
+                    ++providerCalls;
+                    return Array.from({ length: 10000 }, (_, i) => ({ label: `Page ${i}` }));
+                }
+            }]);
+            const win = new BrowserWindow({ show: false });
+            win.setMenu(menu);
+            expect(menu.items[0].submenu.items.map(item => item.label)).to.deep.equal(['Loading…']);
+            expect(providerCalls).to.equal(0);
+            win.setMenu(null);
+            win.destroy();
+        });
+        it('delivers the clicks on a lazy submenu that arrive after it is closed', function () {
+            if (mac) return this.skip();
+            let clicked = null;
+            const menu = Menu.buildFromTemplate([{
+                label: 'History',
+                submenu: () => [{ label: 'Page', click: (item) => { clicked = item; } }]
+            }]);
+            const win = new BrowserWindow({ show: false });
+            win.setMenu(menu);
+            const historyItem = menu.items[0];
+
+            // The order of the native events: the submenu is shown, closed, and then the click arrives
+            historyItem['handleSubmenuShow_']();
+            const pageItem = historyItem.submenu.items[0];
+            expect(pageItem.label).to.equal('Page');
+            const [[template, pageId]] = pageItem['templateNatives_'].values();
+            historyItem['handleSubmenuHide_']();
+            expect(template.itemsById[pageId]).to.equal(pageItem);
+            template.itemsById[pageId]['handleClick_'](win);
+            expect(clicked).to.equal(pageItem);
+
+            // Dropped and loaded again when it is shown the next time
+            historyItem['handleSubmenuShow_']();
+            expect(historyItem.submenu.items[0]).to.not.equal(pageItem);
+            expect(template.itemsById[pageId]).to.equal(undefined);
+            win.setMenu(null);
+            win.destroy();
+        });
+        it('reports the errors of lazy submenus as warnings', async function () {
+            if (mac) return this.skip();
+            const menu = Menu.buildFromTemplate([
+                { label: 'Throws', submenu: () => { throw new Error('provider error'); } },
+                { label: 'Rejects', submenu: () => Promise.reject(new Error('provider rejection')) },
+                { label: 'Nothing', submenu: () => null }
+            ]);
+            const win = new BrowserWindow({ show: false });
+            win.setMenu(menu);
+            const warnings = [];
+            const onWarning = (warning) => warnings.push(warning.message);
+            process.on('warning', onWarning);
+            try {
+                for (const item of menu.items) {
+                    item['handleSubmenuShow_']();
+                }
+                await new Promise(resolve => setImmediate(resolve));
+                expect(warnings).to.include.members(['provider error', 'provider rejection']);
+                expect(menu.items.map(item => item.submenu.items[0].label)).to.deep.equal(['Failed to Load', 'Failed to Load', 'Empty']);
+            }
+            finally {
+                process.removeListener('warning', onWarning);
+                win.setMenu(null);
+                win.destroy();
+            }
+        });
+        it('keeps a menu alive until the updates queued for it have run', async function () {
+            if (mac) return this.skip();
+            require('v8').setFlagsFromString('--expose-gc');
+            const gc = require('vm').runInNewContext('gc');
+            const win = new BrowserWindow({ show: false });
+            try {
+                for (let i = 0; i < 50; ++i) {
+                    const menu = Menu.buildFromTemplate([{ label: 'Edit', submenu: [{ id: 'undo', label: 'Undo' }] }]);
+                    const [nativeId] = menu['createNative_'](1, win);
+                    menu.update([{ label: 'Edit', submenu: [{ id: 'undo', label: `Undo ${i}`, enabled: false }] }]);
+                    // Forgotten without being destroyed, while the update is still queued for the UI thread
+                    menu['forgetNative_'](nativeId);
+                    menu['natives_'].delete(nativeId);
+                    gc();
+                }
+                expect(await win.getPositionAsync()).to.have.lengthOf(2);
+                gc();
+            }
+            finally {
+                win.destroy();
+            }
+        });
+    });
+    describe('a UI transaction that throws', () => {
+        it('throws the native error and leaves later transactions working', function() {
+            if (process.platform !== 'linux') return this.skip();
+            const missingIcon = path.resolve(__dirname, '..', 'fixtures', 'files', 'missing-icon.png');
+            for (let i = 0; i < 5; ++i) {
+                expect(() => new BrowserWindow({ show: false, icon: missingIcon })).to.throw();
+            }
+
+            const win = new BrowserWindow({ show: false, width: 321, height: 123 });
+            try {
+                expect(win.getSize()).to.deep.equal([321, 123]);
+                win.setSize(345, 234);
+                expect(win.getSize()).to.deep.equal([345, 234]);
+            }
+            finally {
+                win.destroy();
+            }
+        });
     });
     describe('win.setTitleBarStyle(style)', () => {
         before(function() {
@@ -3,6 +3,9 @@ const { expect } = require('chai');
 const { createLocalServer, withWebView } = require('../utils');
 const { once } = require('events');
 const path = require('path');
+const fs = require('fs');
+const os = require('os');
+const zlib = require('zlib');
 
 describe('BrowserWindow#webView', () => {
     const windowAllClosedHandler = () => {};
@@ -49,6 +52,371 @@ describe('BrowserWindow#webView', () => {
         }))
     });
 
+    describe('webPreferences.crossOriginIsolated', () => {
+        it('serves local files with the COOP/COEP headers, and wasm as application/wasm', async function() {
+            if (process.platform !== 'linux') return this.skip();
+            const win = new BrowserWindow({ show: false, webPreferences: { crossOriginIsolated: true } });
+            try {
+                const checked = new Promise(resolve => {
+                    win.webView.publishServices({ 'dgtest': { checked: resolve } });
+                });
+                win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-cross-origin-isolated.html'));
+                expect(await checked).to.eql({
+                    isolated: true,
+                    hasSharedArrayBuffer: true,
+                    openerPolicy: 'same-origin',
+                    embedderPolicy: 'require-corp',
+                    wasmType: 'application/wasm',
+                    wasmInstantiated: true
+                });
+            }
+            finally {
+                win.destroy();
+            }
+        });
+
+        withWebView(it, 'leaves the pages that do not request it without the headers', async function(win) {
+            if (process.platform !== 'linux') return this.skip();
+            const checked = new Promise(resolve => {
+                win.webView.publishServices({ 'dgtest': { checked: resolve } });
+            });
+            win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-cross-origin-isolated.html'));
+            const result = await checked;
+            expect(result.isolated).to.equal(false);
+            expect(result.openerPolicy).to.equal(null);
+            expect(result.embedderPolicy).to.equal(null);
+            expect(result.wasmType).to.equal('application/wasm');
+        });
+    });
+
+    describe('precompressed local files', () => {
+        const writePage = (marker) => `<script>window.deskgap.getService('dgtest').send('served', '${marker}')</script>`;
+
+        for (const [description, isGzipOlder, expected] of [
+            ['serves a <file>.gz sibling in place of the file', false, 'gzipped'],
+            ['serves the file when its <file>.gz sibling is older', true, 'original']
+        ]) {
+            withWebView(it, description, async function(win) {
+                if (process.platform !== 'linux') return this.skip();
+                const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'deskgap-gz-'));
+                try {
+                    const filePath = path.join(dir, 'index.html');
+                    fs.writeFileSync(filePath, writePage('original'));
+                    fs.writeFileSync(filePath + '.gz', zlib.gzipSync(writePage('gzipped')));
+                    const now = Date.now() / 1000;
+                    fs.utimesSync(filePath + '.gz', now, isGzipOlder ? now - 60 : now + 60);
+                    const served = new Promise(resolve => {
+                        win.webView.publishServices({ 'dgtest': { served: resolve } });
+                    });
+                    win.webView.loadFile(filePath);
+                    expect(await served).to.equal(expected);
+                }
+                finally {
+                    fs.rmSync(dir, { recursive: true, force: true });
+                }
+            });
+        }
+    });
+
+    describe('asset archives', () => {
+        const packAssets = require('../../npm/pack.js');
+
+        withWebView(it, 'serves the pages and assets packed by deskgap-pack', async function(win) {
+            if (process.platform !== 'linux') return this.skip();
+            const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'deskgap-pack-'));
+            try {
+                const sourceDir = path.join(dir, 'source');
+                fs.mkdirSync(path.join(sourceDir, 'pages', 'data'), { recursive: true });
+                // The script is gzipped in the archive and the binary file is stored as it is
+                fs.writeFileSync(path.join(sourceDir, 'pages', 'index.html'), '<script src="app.js"></script>');
+                fs.writeFileSync(path.join(sourceDir, 'pages', 'app.js'), `// ${'padding '.repeat(100)}
+                    fetch('data/bytes.bin').then(r => r.arrayBuffer()).then(buffer => {
+                        window.deskgap.getService('dgtest').send('loaded', Array.from(new Uint8Array(buffer)));
+                    });
+                `);
+                fs.writeFileSync(path.join(sourceDir, 'pages', 'data', 'bytes.bin'), Buffer.from([0, 1, 2, 255]));
+
+                const archivePath = path.join(dir, 'assets.dgpack');
+                expect(packAssets(sourceDir, archivePath)).to.equal(3);
+
+                const loaded = new Promise(resolve => {
+                    win.webView.publishServices({ 'dgtest': { loaded: resolve } });
+                });
+                win.webView.loadFile(path.join(archivePath, 'pages', 'index.html'));
+                expect(await loaded).to.eql([0, 1, 2, 255]);
+            }
+            finally {
+                fs.rmSync(dir, { recursive: true, force: true });
+            }
+        });
+    });
+
+    describe('ranges of local files', () => {
+        const page = `<script>
+            Promise.all(['bytes=2-5', 'bytes=-3', 'bytes=100-', 'bytes=x-y'].map(async (range) => {
+                const response = await fetch('data.txt', { headers: { 'Range': range } });
+                return [response.status, await response.text()];
+            })).then(results => window.deskgap.getService('dgtest').send('fetched', results));
+        </script>`;
+
+        withWebView(it, 'serves a satisfiable range, rejects one past the end and ignores a malformed one', async function(win) {
+            if (process.platform !== 'linux') return this.skip();
+            const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'deskgap-range-'));
+            try {
+                fs.writeFileSync(path.join(dir, 'index.html'), page);
+                fs.writeFileSync(path.join(dir, 'data.txt'), '0123456789');
+                const fetched = new Promise(resolve => {
+                    win.webView.publishServices({ 'dgtest': { fetched: resolve } });
+                });
+                win.webView.loadFile(path.join(dir, 'index.html'));
+                expect(await fetched).to.eql([
+                    [206, '2345'],
+                    [206, '789'],
+                    [416, ''],
+                    [200, '0123456789']
+                ]);
+            }
+            finally {
+                fs.rmSync(dir, { recursive: true, force: true });
+            }
+        });
+    });
+
+    describe('webView.sendBinary(data)', () => {
+        withWebView(it, 'delivers the bytes to the page and receives binary messages from the page', async (win) => {
+            win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-binary-echo.html'));
+            await once(win.webView, 'did-finish-load');
+            win.webView.sendBinary(Buffer.from([0, 1, 2, 253, 254, 255]));
+            const [, echoed] = await once(win.webView, 'binary-message');
+            expect(Buffer.isBuffer(echoed)).to.equal(true);
+            expect(Array.from(echoed)).to.eql([255, 254, 253, 2, 1, 0]);
+        });
+
+        withWebView(it, 'hands over the received bytes, which stay valid while the other buffers are collected', async (win) => {
+            require('v8').setFlagsFromString('--expose-gc');
+            const gc = require('vm').runInNewContext('gc');
+            win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-binary-echo.html'));
+            await once(win.webView, 'did-finish-load');
+
+            const sizes = [0, 1, 4 * 1024 * 1024, ...Array.from({ length: 16 }, (_, i) => 64 * 1024 + i)];
+            const received = [];
+            const allReceived = new Promise(resolve => {
+                const onMessage = (_, data) => {
+                    received.push(data);
+                    if (received.length === sizes.length) {
+                        win.webView.removeListener('binary-message', onMessage);
+                        resolve();
+                    }
+                };
+                win.webView.on('binary-message', onMessage);
+            });
+            for (const size of sizes) {
+                win.webView.sendBinary(Buffer.alloc(size, size % 256));
+            }
+            await allReceived;
+
+            // Drop every other buffer, so their vectors are freed while the rest are read
+            const kept = received.filter((_, i) => i % 2 === 0);
+            received.length = 0;
+            gc();
+            await new Promise(resolve => setImmediate(resolve));
+            gc();
+            sizes.filter((_, i) => i % 2 === 0).forEach((size, i) => {
+                expect(Buffer.isBuffer(kept[i])).to.equal(true);
+                expect(kept[i].length).to.equal(size);
+                expect(kept[i].every(byte => byte === 255 - size % 256)).to.equal(true);
+            });
+        });
+
+        withWebView(it, 'sends the bytes viewed by a DataView and rejects what is not binary data', async (win) => {
+            win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-binary-echo.html'));
+            await once(win.webView, 'did-finish-load');
+            const buffer = new Uint8Array([9, 0, 1, 2, 9]).buffer;
+            win.webView.sendBinary(new DataView(buffer, 1, 3));
+            const [, echoed] = await once(win.webView, 'binary-message');
+            expect(Array.from(echoed)).to.eql([2, 1, 0]);
+            expect(() => win.webView.sendBinary([0, 1, 2])).to.throw(TypeError);
+        });
+
+        withWebView(it, 'drops the bytes sent to a remote page, and delivers them again once a local page is loaded', async function(win) {
+            if (process.platform !== 'linux') return this.skip();
+            win.webView.loadURL('data:text/html,<title>Remote</title>');
+            await once(win.webView, 'did-finish-load');
+            for (let i = 0; i < 16; ++i) {
+                win.webView.sendBinary(Buffer.alloc(1024 * 1024, 1));
+            }
+
+            win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-binary-echo.html'));
+            await once(win.webView, 'did-finish-load');
+            win.webView.sendBinary(Buffer.from([0, 1, 2]));
+            const [, echoed] = await once(win.webView, 'binary-message');
+            expect(Array.from(echoed)).to.eql([255, 254, 253]);
+        });
+    });
+
+    describe('events of the native objects', () => {
+        const burstCount = 10000;
+        const blockNodeThread = (ms) => Atomics.wait(new Int32Array(new SharedArrayBuffer(4)), 0, 0, ms);
+
+        withWebView(it, 'delivers a burst larger than the event ring in order', async (win) => {
+            const received = [];
+            const allReceived = new Promise(resolve => {
+                win.webView.publishServices({
+                    'dgtest': {
+                        received(i) {
+                            // The UI thread keeps sending while the events overflow the ring
+                            if (i === 0) blockNodeThread(500);
+                            received.push(i);
+                            if (received.length === burstCount) resolve();
+                        }
+                    }
+                });
+            });
+            win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-message-burst.html'));
+            await allReceived;
+            expect(received).to.eql(Array.from({ length: burstCount }, (_, i) => i));
+        });
+
+        it('drops the events of a destroyed object', async () => {
+            const win = new BrowserWindow({ show: false });
+            let receivedAfterDestroy = 0;
+            let isDestroyed = false;
+            const destroyed = new Promise(resolve => {
+                win.webView.publishServices({
+                    'dgtest': {
+                        received(i) {
+                            if (isDestroyed) {
+                                ++receivedAfterDestroy;
+                                return;
+                            }
+                            if (i === 0) {
+                                blockNodeThread(500);
+                                // The events queued until now belong to a removed target
+                                win.destroy();
+                                isDestroyed = true;
+                                resolve();
+                            }
+                        }
+                    }
+                });
+            });
+            win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-message-burst.html'));
+            await destroyed;
+            await new Promise(resolve => setTimeout(resolve, 200));
+            expect(receivedAfterDestroy).to.equal(0);
+        });
+    });
+
+    describe('webView.getService(services).send(...)', () => {
+        withWebView(it, 'delivers the rest of a batch after a handler in the page throws', async (win) => {
+            const echoed = [];
+            let reported = null;
+            const done = new Promise(resolve => {
+                const check = () => {
+                    if (echoed.length === 2 && reported != null) resolve();
+                };
+                win.webView.publishServices({
+                    'dgtest': {
+                        echoed(i) { echoed.push(i); check(); },
+                        reported(message) { reported = message; check(); }
+                    }
+                });
+            });
+            win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-message-batch.html'));
+            await once(win.webView, 'did-finish-load');
+            // Sent in one tick, so they are joined into one delivery
+            const batch = win.webView.getService('batch');
+            batch.send('echo', 1);
+            batch.send('fail');
+            batch.send('echo', 2);
+            await done;
+            expect(echoed).to.eql([1, 2]);
+            expect(reported).to.include('handler error');
+        });
+    });
+
+    describe('string messages from the page', () => {
+        withWebView(it, 'receives the strings stored in 8 and in 16 bits by the engine of the page', async (win) => {
+            const strings = ['ascii', 'caf\u00e9 \u00ff', '\u4f60\u597d \ud83d\ude00', 'x'.repeat(100000)];
+            const echoed = [];
+            const done = new Promise(resolve => {
+                win.webView.publishServices({
+                    'dgtest': {
+                        echoed(s) {
+                            echoed.push(s);
+                            if (echoed.length === strings.length) resolve();
+                        },
+                        reported() { }
+                    }
+                });
+            });
+            win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-message-batch.html'));
+            await once(win.webView, 'did-finish-load');
+            for (const s of strings) {
+                win.webView.getService('batch').send('echo', s);
+            }
+            await done;
+            expect(echoed).to.eql(strings);
+        });
+    });
+
+    describe('webView.getIpcStats()', () => {
+        const echoAll = async (win, messages) => {
+            const echoed = [];
+            const done = new Promise(resolve => {
+                win.webView.publishServices({
+                    'dgtest': {
+                        echoed(message) {
+                            echoed.push(message);
+                            if (echoed.length === messages.length) resolve();
+                        },
+                        reported() { }
+                    }
+                });
+            });
+            for (const message of messages) {
+                win.webView.getService('batch').send('echo', message);
+            }
+            await done;
+            return echoed;
+        };
+
+        withWebView(it, 'counts the messages in both directions and only times their serialization when enabled', async (win) => {
+            win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-message-batch.html'));
+            await once(win.webView, 'did-finish-load');
+            const messages = Array.from({ length: 100 }, (_, i) => ({ i, payload: 'x'.repeat(10000) }));
+
+            const before = win.webView.getIpcStats();
+            expect(await echoAll(win, messages)).to.eql(messages);
+            const untimed = win.webView.getIpcStats();
+            expect(untimed.messagesToPage - before.messagesToPage).to.be.at.least(messages.length);
+            expect(untimed.messagesFromPage - before.messagesFromPage).to.be.at.least(messages.length);
+            expect(untimed.bytesToPage - before.bytesToPage).to.be.at.least(messages.length * 10000);
+            expect(untimed.batchesToPage - before.batchesToPage).to.be.within(1, messages.length);
+            // The last batch is in flight until the page has finished running it, which may be after the echoes
+            for (let i = 0; i < 100 && win.webView.getIpcStats().queueDepth > 0; ++i) {
+                await new Promise(resolve => setTimeout(resolve, 10));
+            }
+            expect(win.webView.getIpcStats().queueDepth).to.equal(0);
+            expect(untimed.totalSerializationTime).to.equal(0);
+            expect(untimed.totalDeserializationTime).to.equal(0);
+
+            win.webView.setIpcStatsEnabled(true);
+            await echoAll(win, messages);
+            const timed = win.webView.getIpcStats();
+            expect(timed.totalSerializationTime).to.be.above(0);
+            expect(timed.totalDeserializationTime).to.be.above(0);
+        });
+
+        withWebView(it, 'emits the stats periodically', async (win) => {
+            win.webView.setIpcStatsInterval(10);
+            const [, stats] = await once(win.webView, 'ipc-stats');
+            win.webView.setIpcStatsInterval(0);
+            expect(stats).to.have.property('messagesToPage').that.is.a('number');
+            expect(stats).to.have.property('totalSerializationTime').that.is.a('number');
+        });
+    });
+
     describe('webView.getService(services).call(...)', () => {
         withWebView(it, 'calls services published on the browser side', async (win) => {
             win.webView.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'web-view-side-services.html'));
@@ -115,4 +115,75 @@ describe('webViews', () => {
         
     });
 
+    describe('webViews.setPoolSize(size)', () => {
+        afterEach(() => {
+            webViews.setPoolSize(0);
+        });
+
+        it('fills the pool and hands the pooled WebViews to new windows', async () => {
+            webViews.setPoolSize(1);
+            for (let i = 0; i < 500 && webViews.getPooledWebViewCount() < 1; ++i) {
+                await new Promise(resolve => setTimeout(resolve, 20));
+            }
+            expect(webViews.getPooledWebViewCount()).to.equal(1);
+
+            const window = new BrowserWindow({ show: false });
+            try {
+                expect(webViews.getPooledWebViewCount()).to.equal(0);
+                window.loadFile(path.resolve(__dirname, '..', 'fixtures', 'files', 'blank.html'));
+                await once(window.webView, 'did-finish-load');
+            }
+            finally {
+                window.destroy();
+            }
+            expect(window.webView.isDestroyed()).to.be.true;
+        });
+
+        it('does not hand pooled WebViews to partitioned windows', async () => {
+            webViews.setPoolSize(1);
+            for (let i = 0; i < 500 && webViews.getPooledWebViewCount() < 1; ++i) {
+                await new Promise(resolve => setTimeout(resolve, 20));
+            }
+            const window = new BrowserWindow({ show: false, webPreferences: { partition: 'pool-test' } });
+            window.destroy();
+            expect(webViews.getPooledWebViewCount()).to.equal(1);
+        });
+    });
+
+    describe('webPreferences.partition', () => {
+        const blankPath = path.resolve(__dirname, '..', 'fixtures', 'files', 'blank.html');
+        const openLoaded = async (partition) => {
+            const window = new BrowserWindow({ show: false, webPreferences: { partition } });
+            window.loadFile(blankPath);
+            await once(window.webView, 'did-finish-load');
+            return window;
+        };
+
+        afterEach(() => {
+            webViews.setContextOptions({});
+        });
+
+        it('keeps serving a partition while its windows come and go', async function() {
+            if (process.platform !== 'linux') return this.skip();
+            const first = await openLoaded('partition-test');
+            const second = await openLoaded('partition-test');
+            // The next window is related to the one that is left
+            first.destroy();
+            const third = await openLoaded('partition-test');
+            second.destroy();
+            third.destroy();
+
+            // The context is created again once every window of the partition is gone
+            (await openLoaded('partition-test')).destroy();
+        });
+
+        it('loads pages in windows of different partitions side by side', async function() {
+            if (process.platform !== 'linux') return this.skip();
+            webViews.setContextOptions({ cacheModel: 'document-viewer', webProcessCountLimit: 1 });
+            const windows = await Promise.all([openLoaded('partition-a'), openLoaded('partition-b'), openLoaded(undefined)]);
+            for (const window of windows) {
+                window.destroy();
+            }
+        });
+    });
 });
@@ -0,0 +1,41 @@
+const { app, BrowserWindow, Worker } = require('deskgap');
+const { expect } = require('chai');
+const { once } = require('events');
+const path = require('path');
+
+describe('Worker', () => {
+    before(async () => {
+        await app.whenReady();
+    });
+
+    it('runs a worker thread that can require deskgap and load a page in its own window', async () => {
+        const windowCount = BrowserWindow.getAllWindows().length;
+        const worker = new Worker(path.resolve(__dirname, '..', 'fixtures', 'modules', 'worker-browser-window.js'));
+        try {
+            const [message] = await once(worker, 'message');
+            expect(message).to.equal('loaded');
+            expect(BrowserWindow.getAllWindows().length).to.equal(windowCount);
+        }
+        finally {
+            await worker.terminate();
+        }
+    });
+
+    it('destroys the windows that a terminated worker leaves alive', async () => {
+        const worker = new Worker(path.resolve(__dirname, '..', 'fixtures', 'modules', 'worker-live-window.js'));
+        const [message] = await once(worker, 'message');
+        expect(message).to.equal('loaded');
+        await worker.terminate();
+
+        // The UI thread and the main env still work after the window of the worker is gone
+        const win = new BrowserWindow({ show: false });
+        try {
+            win.setTitle('after worker');
+            expect(win.getTitle()).to.equal('after worker');
+            expect(await win.getPositionAsync()).to.have.lengthOf(2);
+        }
+        finally {
+            win.destroy();
+        }
+    });
+});
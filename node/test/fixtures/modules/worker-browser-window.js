@@ -0,0 +1,16 @@
+const { app, BrowserWindow } = require('deskgap');
+const { parentPort } = require('worker_threads');
+const path = require('path');
+
+app.whenReady().then(() => {
+    const win = new BrowserWindow({ show: false });
+    win.webView.publishServices({
+        'dgtest': {
+            loaded() {
+                win.destroy();
+                parentPort.postMessage('loaded');
+            }
+        }
+    });
+    win.webView.loadFile(path.resolve(__dirname, '..', 'files', 'web-view-load-file.html'));
+});
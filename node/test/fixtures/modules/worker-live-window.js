@@ -0,0 +1,21 @@
+const { app, BrowserWindow } = require('deskgap');
+const { parentPort } = require('worker_threads');
+const path = require('path');
+
+app.whenReady().then(() => {
+    const win = new BrowserWindow({ show: false });
+    win.webView.publishServices({
+        'dgtest': {
+            loaded() {
+                // Left alive for the terminated worker to destroy
+                parentPort.postMessage('loaded');
+                // Keep the window busy while the worker is terminated
+                setInterval(() => {
+                    win.setTitle(String(Date.now()));
+                    win.getPosition();
+                }, 1);
+            }
+        }
+    });
+    win.webView.loadFile(path.resolve(__dirname, '..', 'files', 'web-view-load-file.html'));
+});
@@ -0,0 +1,13 @@
+const { app, BrowserWindow } = require('deskgap');
+const { parentPort, workerData } = require('worker_threads');
+
+app.whenReady().then(() => {
+    const win = new BrowserWindow({ show: false });
+    win.setTitle('worker');
+    let matched = 0;
+    for (let i = 0; i < workerData.count; i++) {
+        if (win.getTitle() === 'worker') matched++;
+    }
+    win.destroy();
+    parentPort.postMessage(matched);
+});
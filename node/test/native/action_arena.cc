@@ -0,0 +1,129 @@
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "../../src/node_bindings/dispatch/action_arena.h"
+
+namespace {
+    using DeskGap::ActionArena;
+
+    int failureCount = 0;
+
+    void Expect(bool condition, const char* description) {
+        if (!condition) {
+            std::fprintf(stderr, "FAILED: %s\n", description);
+            ++failureCount;
+        }
+    }
+
+    // Larger than a block of the arena
+    struct LargeAction {
+        std::vector<int>* order;
+        int index;
+        std::array<int, 8 * 1024> payload;
+
+        void operator()() {
+            if (payload.front() != index || payload.back() != index) {
+                throw std::logic_error("The payload of a queued action is overwritten");
+            }
+            order->push_back(index);
+        }
+    };
+
+    void EmplaceSmall(ActionArena& arena, std::vector<int>& order, int index) {
+        arena.Emplace([&order, index]() { order.push_back(index); });
+    }
+    void EmplaceLarge(ActionArena& arena, std::vector<int>& order, int index) {
+        auto action = std::make_unique<LargeAction>();
+        action->order = &order;
+        action->index = index;
+        action->payload.fill(index);
+        arena.Emplace(std::move(*action));
+    }
+
+    std::vector<int> Sequence(int count) {
+        std::vector<int> result;
+        for (int i = 0; i < count; ++i) result.push_back(i);
+        return result;
+    }
+
+    void TestLargeActionsBetweenSmallOnes() {
+        ActionArena arena;
+        // The rounds after the first reuse the blocks of the previous ones
+        for (int round = 0; round < 3; ++round) {
+            std::vector<int> order;
+            int index = 0;
+            EmplaceSmall(arena, order, index++);
+            EmplaceSmall(arena, order, index++);
+            EmplaceLarge(arena, order, index++);
+            for (int i = 0; i < 1000; ++i) {
+                EmplaceSmall(arena, order, index++);
+            }
+            EmplaceLarge(arena, order, index++);
+            EmplaceLarge(arena, order, index++);
+            EmplaceSmall(arena, order, index++);
+
+            try {
+                arena.RunUntil([]() { return false; });
+            }
+            catch (const std::logic_error& error) {
+                Expect(false, error.what());
+            }
+            Expect(arena.Empty(), "All the actions are run");
+            Expect(order == Sequence(index), "The actions are run in the order they are queued");
+        }
+    }
+
+    void TestThrowingLastAction() {
+        ActionArena arena;
+        std::vector<int> order;
+        for (int round = 0; round < 3; ++round) {
+            order.clear();
+            EmplaceSmall(arena, order, 0);
+            arena.Emplace([]() { throw std::runtime_error("The last action"); });
+            bool hasThrown = false;
+            try {
+                arena.RunUntil([]() { return false; });
+            }
+            catch (const std::runtime_error&) {
+                hasThrown = true;
+            }
+            Expect(hasThrown, "The exception of an action propagates");
+            Expect(arena.Empty(), "An action that throws is removed");
+            Expect(order == Sequence(1), "The actions before the one that throws are run");
+        }
+
+        order.clear();
+        EmplaceSmall(arena, order, 0);
+        EmplaceLarge(arena, order, 1);
+        EmplaceSmall(arena, order, 2);
+        arena.RunUntil([]() { return false; });
+        Expect(order == Sequence(3), "The arena is reused after an action throws");
+    }
+
+    void TestYielding() {
+        ActionArena arena;
+        std::vector<int> order;
+        for (int i = 0; i < 10; ++i) {
+            EmplaceSmall(arena, order, i);
+        }
+        arena.RunUntil([]() { return true; });
+        Expect(order == Sequence(1), "Running yields after an action");
+        EmplaceLarge(arena, order, 10);
+        EmplaceSmall(arena, order, 11);
+        arena.RunUntil([]() { return false; });
+        Expect(order == Sequence(12), "The actions queued while yielding are run after the others");
+    }
+}
+
+int main() {
+    TestLargeActionsBetweenSmallOnes();
+    TestThrowingLastAction();
+    TestYielding();
+    if (failureCount > 0) {
+        return 1;
+    }
+    std::printf("ActionArena: all tests passed\n");
+    return 0;
+}
@@ -12,11 +12,12 @@ class DeskGapProcessError extends Error {
     }
 }
 
-const spawnDeskGapAsync = (entryPath, args) => {
+const spawnDeskGapAsync = (entryPath, args, env = {}) => {
     const spawnedDeskGap = spawn(process.argv0, args, {
         windowsHide: false,
         env: {
             ...process.env,
+            ...env,
             'DESKGAP_ENTRY': entryPath
         }
     });
@@ -52,6 +53,10 @@ exports.spawnDeskGapAppAsync = (appName, ...args) => {
     return spawnDeskGapAsync(path.join(__dirname, 'fixtures', 'apps', appName), args);
 };
 
+exports.spawnDeskGapAppWithEnvAsync = (appName, env, ...args) => {
+    return spawnDeskGapAsync(path.join(__dirname, 'fixtures', 'apps', appName), args, env);
+};
+
 exports.createLocalServer = (handlers) => {
     const koa = new Koa();
 